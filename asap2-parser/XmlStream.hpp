@@ -17,9 +17,20 @@
 #pragma once
 
 #include <cassert>
-#include <sstream>
-#include <stack>
-
+#include <charconv>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "stringRef.hpp"
+#include "xmlEscape.h"
+
+// Writes XML to a stream as it is generated. Tag and attribute names are
+// string literals, which are referred to and not copied, and numbers are
+// formatted with std::to_chars straight into the buffer of the stream, so
+// writing a document does not allocate. Strings are escaped and converted
+// to UTF-8, see writeEscaped().
 namespace xml
 {
 using namespace std;
@@ -27,54 +38,48 @@ using namespace std;
 struct XmlElement
 { };
 
+// a string literal, or the string of a content
+template<class Ch>
+struct XmlName
+{
+    const Ch* m_data;
+    size_t m_length;
+};
+
 template<class Ch, class Tr = char_traits<Ch> >
 struct XmlAttribute : public XmlElement
 {
-    const basic_string<Ch, Tr> m_name;
-//    const basic_string<Ch, Tr> m_content;
-
-    XmlAttribute(
-        const basic_string<Ch, Tr>& name) :
-//        const basic_string<Ch, Tr>& content) :
-        m_name(name)
-//        m_content(content)
-    { }
+    XmlName<Ch> m_name;
 
-    // copy constructor
-    XmlAttribute(const XmlAttribute& attribute) :
-        m_name(attribute.m_name)
-//        m_content(attribute.m_content)
-    { }
+    XmlAttribute(const Ch* name, size_t length)
+    {
+        m_name.m_data = name;
+        m_name.m_length = length;
+    }
 };
 
 template<class Ch, class Tr = char_traits<Ch> >
 struct XmlContent : public XmlElement
 {
-    const basic_string<Ch, Tr> m_content;
-
-    XmlContent(const basic_string<Ch, Tr>& content) :
-        m_content(content)
-    { }
+    XmlName<Ch> m_content; // valid until the end of the expression
 
-    // copy constructor
-    XmlContent(const XmlContent& content) :
-        m_content(content.m_content)
-    { }
+    XmlContent(const Ch* content, size_t length)
+    {
+        m_content.m_data = content;
+        m_content.m_length = length;
+    }
 };
 
 template<class Ch, class Tr = char_traits<Ch> >
 struct XmlStartTag : public XmlElement
 {
-    const basic_string<Ch, Tr> m_name;
-
-    XmlStartTag(const basic_string<Ch, Tr> name) :
-        m_name(name)
-    { }
+    XmlName<Ch> m_name;
 
-    // copy constructor
-    XmlStartTag(const XmlStartTag& startTag) :
-        m_name(startTag.m_name)
-    { }
+    XmlStartTag(const Ch* name, size_t length)
+    {
+        m_name.m_data = name;
+        m_name.m_length = length;
+    }
 };
 
 struct XmlEndTag : public XmlElement
@@ -84,10 +89,15 @@ struct XmlEndTag : public XmlElement
     XmlEndTag(int count) :
         m_count(count)
     { }
+};
 
-    // copy constructor
-    XmlEndTag(const XmlEndTag& endTag) :
-        m_count(endTag.m_count)
+// an unsigned number as 0x..., like std::hex << "0x" << value
+struct XmlHex : public XmlElement
+{
+    unsigned long m_value;
+
+    XmlHex(unsigned long value) :
+        m_value(value)
     { }
 };
 
@@ -96,16 +106,19 @@ class XmlStream
 {
 public:
     typedef XmlStream my_type;
-    typedef basic_stringstream<Ch, Tr> stream_type;
-    typedef stack<basic_string<Ch, Tr> > stack_type;
+    typedef basic_ostream<Ch, Tr> stream_type; // written as the tags are closed
+    typedef vector<XmlName<Ch> > stack_type;   // the names of the open tags
 
     enum State { InContent, InAttribute, InAttributeBlock, TagEnd, None };
 
     XmlStream(stream_type& stream) :
         m_state(None),
         m_tags(),
-        m_stream(stream)
-    { }
+        m_stream(stream),
+        m_base(10)
+    {
+        m_tags.reserve(16); // deeper than any XDF
+    }
 
     my_type& operator <<(const XmlAttribute<Ch, Tr>& attribute)
     {
@@ -114,8 +127,9 @@ public:
             throw ios_base::failure("not in attribute block");
         }
 
-        m_stream << ' ' << attribute.m_name << "=\"";
-//                 << attribute.m_content << '"';
+        put(' ');
+        put(attribute.m_name);
+        put("=\"", 2);
         m_state = InAttribute;
 
         return *this;
@@ -125,10 +139,10 @@ public:
     {
         tryToCloseAttribute();
         if (m_state == InAttributeBlock) {
-            m_stream << '>';
+            put('>');
         }
 
-        m_stream << content.m_content;
+        text(content.m_content.m_data, content.m_content.m_length);
         m_state = InContent;
 
         return *this;
@@ -138,13 +152,14 @@ public:
     {
         tryToCloseAttribute();
         if (m_state == InAttributeBlock) {
-            m_stream << ">\n";
+            put(">\n", 2);
         }
 
         incise();
-        m_stream << '<' << startTag.m_name;
+        put('<');
+        put(startTag.m_name);
 
-        m_tags.push(startTag.m_name);
+        m_tags.push_back(startTag.m_name);
         m_state = InAttributeBlock;
 
         return *this;
@@ -156,12 +171,58 @@ public:
         return *this;
     }
 
+    my_type& operator <<(const XmlHex& hex)
+    {
+        put("0x", 2);
+        putNumber(hex.m_value, 16);
+        return *this;
+    }
+
     // handle function pointers
     my_type& operator <<(my_type& (*f)(my_type&))
     {
         return f(*this);
     }
 
+    // std::hex and std::dec switch the base of the integers
+    my_type& operator <<(ios_base& (*f)(ios_base&))
+    {
+        if (f == static_cast<ios_base& (*)(ios_base&)>(std::hex)) m_base = 16;
+        else if (f == static_cast<ios_base& (*)(ios_base&)>(std::dec)) m_base = 10;
+        else f(m_stream);
+
+        return *this;
+    }
+
+    my_type& operator <<(const Ch* str)
+    {
+        text(str, Tr::length(str));
+        return *this;
+    }
+
+    my_type& operator <<(const basic_string<Ch, Tr>& str)
+    {
+        text(str.data(), str.size());
+        return *this;
+    }
+
+    my_type& operator <<(const StringRef& str)
+    {
+        text(str.data, str.length);
+        return *this;
+    }
+
+    my_type& operator <<(short value)              { putNumber(value, m_base); return *this; }
+    my_type& operator <<(unsigned short value)     { putNumber(value, m_base); return *this; }
+    my_type& operator <<(int value)                { putNumber(value, m_base); return *this; }
+    my_type& operator <<(unsigned int value)       { putNumber(value, m_base); return *this; }
+    my_type& operator <<(long value)               { putNumber(value, m_base); return *this; }
+    my_type& operator <<(unsigned long value)      { putNumber(value, m_base); return *this; }
+
+    // like the default format of a stream, %g with 6 digits
+    my_type& operator <<(float value)              { putFloat(value); return *this; }
+    my_type& operator <<(double value)             { putFloat(value); return *this; }
+
     // delegate all remaining types to stream_type
     template<class T>
     my_type& operator <<(const T& value)
@@ -176,31 +237,36 @@ public:
 
         tryToCloseAttribute();
         for (int i = count; i > 0; --i) {
-            basic_string<Ch, Tr>& currentTag = m_tags.top();
+            const XmlName<Ch>& currentTag = m_tags.back();
 
             switch (m_state) {
             case TagEnd:
                 incise(-1);
             case InContent:
-                m_stream << "</" << currentTag << ">\n";
+                put("</", 2);
+                put(currentTag);
+                put(">\n", 2);
                 break;
             case InAttributeBlock:
-                m_stream << " />\n";
+                put(" />\n", 4);
                 break;
             default:
                 throw ios_base::failure("all tags closed");
             }
 
-            m_tags.pop();
+            m_tags.pop_back();
         }
 
         if (m_tags.empty()) m_state = None;
         else m_state = TagEnd;//InContent;
     }
 
-    basic_string<Ch, Tr> str() const
+    // continues a document in which tag is open, e.g. to write a part of
+    // it into another buffer
+    void resume(const XmlStartTag<Ch, Tr>& tag)
     {
-        return m_stream.str();
+        m_tags.push_back(tag.m_name);
+        m_state = TagEnd;
     }
 
     void enterContent()
@@ -210,18 +276,57 @@ public:
         }
 
         m_state = InContent;
-        m_stream << '>';
+        put('>');
     }
 
 private:
     State m_state;
     stack_type m_tags;
     stream_type& m_stream;
+    int m_base; // of the integers
+
+    // straight into the buffer of the stream
+    void put(Ch c)
+    {
+        m_stream.rdbuf()->sputc(c);
+    }
+
+    void put(const Ch* str, size_t length)
+    {
+        m_stream.rdbuf()->sputn(str, length);
+    }
+
+    void put(const XmlName<Ch>& name)
+    {
+        put(name.m_data, name.m_length);
+    }
+
+    // a string in a content or an attribute value
+    void text(const char* str, size_t length)
+    {
+        writeEscaped(*m_stream.rdbuf(), str, str + length);
+    }
+
+    template<class T>
+    void putNumber(T value, int base)
+    {
+        char buffer[24];
+        to_chars_result result = to_chars(buffer, buffer + sizeof(buffer), value, base);
+        put(buffer, result.ptr - buffer);
+    }
+
+    template<class T>
+    void putFloat(T value)
+    {
+        char buffer[32];
+        to_chars_result result = to_chars(buffer, buffer + sizeof(buffer), value, chars_format::general, 6);
+        put(buffer, result.ptr - buffer);
+    }
 
     bool tryToCloseAttribute()
     {
         if (m_state == InAttribute) {
-            m_stream << '"';
+            put('"');
             m_state = InAttributeBlock;
             return true;
         }
@@ -231,39 +336,33 @@ private:
 
     void incise(int offset = 0)
     {
+        static const Ch spaces[] = "                                ";
+
         int i = m_tags.size() + offset;
-        for (; i != 0; --i) m_stream << "  ";
+        for (; i > 16; i -= 16) put(spaces, 32);
+        if (i > 0) put(spaces, 2 * i);
     }
 };
 
-template<class Ch, class Tr>
-inline const XmlAttribute<Ch, Tr> attribute(
-    const basic_string<Ch, Tr>& name)
-//    const basic_string<Ch, Tr>& content)
-{
-    return XmlAttribute<Ch, Tr>(name);//, content);
-}
-
-template<class Ch>
+template<class Ch, size_t N>
 inline const XmlAttribute<Ch> attribute(
-    const Ch* name)
-//    const Ch* content)
+    const Ch (&name)[N])
 {
-    return XmlAttribute<Ch>(basic_string<Ch>(name));//, basic_string<Ch>(content));
+    return XmlAttribute<Ch>(name, N - 1);
 }
 
 template<class Ch, class Tr>
 inline const XmlContent<Ch, Tr> content(
     const basic_string<Ch, Tr>& str)
 {
-    return XmlContent<Ch, Tr>(str);
+    return XmlContent<Ch, Tr>(str.data(), str.size());
 }
 
 template<class Ch>
 inline const XmlContent<Ch> content(
     const Ch* str)
 {
-    return XmlContent<Ch>(basic_string<Ch>(str));
+    return XmlContent<Ch>(str, char_traits<Ch>::length(str));
 }
 
 template<class Ch, class Tr>
@@ -273,18 +372,11 @@ XmlStream<Ch, Tr>& content(XmlStream<Ch, Tr>& stream)
     return stream;
 }
 
-template<class Ch, class Tr>
-inline const XmlStartTag<Ch, Tr> startTag(
-    const basic_string<Ch, Tr>& name)
-{
-    return XmlStartTag<Ch, Tr>(name);
-}
-
-template<class Ch>
+template<class Ch, size_t N>
 inline const XmlStartTag<Ch> startTag(
-    const Ch* name)
+    const Ch (&name)[N])
 {
-    return XmlStartTag<Ch>(basic_string<Ch>(name));
+    return XmlStartTag<Ch>(name, N - 1);
 }
 
 inline const XmlEndTag endTag(int count = 1)
@@ -299,4 +391,9 @@ XmlStream<Ch, Tr>& endTag(XmlStream<Ch, Tr>& stream)
     return stream;
 }
 
+inline const XmlHex hex(unsigned long value)
+{
+    return XmlHex(value);
+}
+
 } // end namespace xml
@@ -0,0 +1,114 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+
+#include "arena.h"
+
+// the block header is padded, so block data is aligned like malloc'ed memory
+static const std::size_t headerSize =
+    (sizeof(void*) + sizeof(std::size_t) + Arena::DefaultAlignment - 1) & ~(Arena::DefaultAlignment - 1);
+
+Arena::Arena(std::size_t blockSize) :
+    m_blockSize(blockSize),
+    m_blocks(0),
+    m_current(0),
+    m_offset(0),
+    m_capacity(0),
+    m_total(0),
+    m_finalizers(0)
+{ }
+
+Arena::~Arena()
+{
+    release();
+}
+
+void Arena::release()
+{
+    for (Finalizer* i = m_finalizers; i != 0; i = i->next) {
+        i->destroy(i->object);
+    }
+    m_finalizers = 0;
+
+    while (m_blocks != 0) {
+        Block* next = m_blocks->next;
+        std::free(m_blocks);
+        m_blocks = next;
+    }
+
+    m_current = 0;
+    m_offset = 0;
+    m_capacity = 0;
+    m_total = 0;
+}
+
+void Arena::rewind(const Mark& mark)
+{
+    while (m_finalizers != mark.finalizers) {
+        m_finalizers->destroy(m_finalizers->object);
+        m_finalizers = m_finalizers->next;
+    }
+
+    // all blocks in front of the marked one are newer
+    while (m_blocks != mark.blocks) {
+        Block* next = m_blocks->next;
+        std::free(m_blocks);
+        m_blocks = next;
+    }
+
+    m_current = mark.current;
+    m_offset = mark.offset;
+    m_capacity = mark.capacity;
+    m_total = mark.total;
+}
+
+StringRef Arena::copy(const char* str, std::size_t length)
+{
+    char* data = static_cast<char*>(allocate(length, 1));
+    std::memcpy(data, str, length);
+    return makeStringRef(data, length);
+}
+
+char* Arena::newBlock(std::size_t size)
+{
+    Block* block = static_cast<Block*>(std::malloc(headerSize + size));
+    if (block == 0) throw std::bad_alloc();
+
+    block->next = m_blocks;
+    block->size = size;
+    m_blocks = block;
+    m_total += size;
+
+    return reinterpret_cast<char*>(block) + headerSize;
+}
+
+void* Arena::allocateSlow(std::size_t size, std::size_t alignment)
+{
+    // big objects get a block of their own, so the rest of the current
+    // block is not wasted
+    if (size + alignment > m_blockSize / 4) {
+        std::size_t data = reinterpret_cast<std::size_t>(newBlock(size + alignment));
+        return reinterpret_cast<void*>((data + alignment - 1) & ~(alignment - 1));
+    }
+
+    m_current = newBlock(m_blockSize);
+    m_offset = 0;
+    m_capacity = m_blockSize;
+
+    return allocate(size, alignment);
+}
@@ -0,0 +1,170 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "stringRef.hpp"
+
+// A bump allocator for everything that lives as long as a parsed project.
+// Allocations are never freed one by one; release() (or the destructor)
+// drops all of them at once. Objects which own memory outside of the arena
+// can register a finalizer, their destructors run on release().
+class Arena
+{
+    struct Block;
+    struct Finalizer;
+
+public:
+    enum { DefaultAlignment = alignof(std::max_align_t) };
+
+    explicit Arena(std::size_t blockSize = 256 * 1024);
+    ~Arena();
+
+    void* allocate(std::size_t size, std::size_t alignment = DefaultAlignment)
+    {
+        std::size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+        if (offset + size > m_capacity) {
+            return allocateSlow(size, alignment);
+        }
+
+        m_offset = offset + size;
+        return m_current + offset;
+    }
+
+    // copies a string into the arena
+    StringRef copy(const char* str, std::size_t length);
+    StringRef copy(const StringRef& str) { return copy(str.data, str.length); }
+
+    // constructs a T in the arena, its destructor is not called
+    template<class T, class... Args>
+    T* create(Args&&... args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // calls object->~T() on release(), in reverse order of registration
+    template<class T>
+    void addFinalizer(T* object)
+    {
+        Finalizer* finalizer = create<Finalizer>();
+        finalizer->destroy = &destroy<T>;
+        finalizer->object = object;
+        finalizer->next = m_finalizers;
+        m_finalizers = finalizer;
+    }
+
+    void release();
+
+    // The state of the arena at some point. rewind() drops everything
+    // allocated since and runs the finalizers registered since.
+    struct Mark
+    {
+        Block* blocks;
+        char* current;
+        std::size_t offset;
+        std::size_t capacity;
+        std::size_t total;
+        Finalizer* finalizers;
+    };
+
+    Mark mark() const
+    {
+        Mark mark = { m_blocks, m_current, m_offset, m_capacity, m_total, m_finalizers };
+        return mark;
+    }
+
+    void rewind(const Mark& mark);
+
+    // memory held by the arena, including unused block space
+    std::size_t capacity() const { return m_total; }
+
+private:
+    // noncopyable
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+
+    struct Block
+    {
+        Block* next;
+        std::size_t size;
+    };
+
+    struct Finalizer
+    {
+        void (*destroy)(void*);
+        void* object;
+        Finalizer* next;
+    };
+
+    template<class T>
+    static void destroy(void* object)
+    {
+        static_cast<T*>(object)->~T();
+    }
+
+    void* allocateSlow(std::size_t size, std::size_t alignment);
+    char* newBlock(std::size_t size);
+
+    std::size_t m_blockSize;
+    Block* m_blocks;
+    char* m_current;        // data of the block we bump-allocate from
+    std::size_t m_offset;
+    std::size_t m_capacity;
+    std::size_t m_total;
+    Finalizer* m_finalizers;
+};
+
+// Lets standard containers allocate from an Arena. deallocate() is a no-op,
+// so containers built with it may be dropped without running their destructor.
+template<class T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    ArenaAllocator(Arena& arena) : m_arena(&arena) { }
+
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.arena()) { }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) { }
+
+    Arena* arena() const { return m_arena; }
+
+private:
+    Arena* m_arena;
+};
+
+template<class T, class U>
+inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.arena() == b.arena();
+}
+
+template<class T, class U>
+inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.arena() != b.arena();
+}
@@ -0,0 +1,151 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "scan.hpp"
+#include "blockIndex.h"
+
+#define LITERAL(str) str, sizeof(str) - 1
+
+static bool startsWith(const char* p, const char* end, const char* str, std::size_t length)
+{
+    return (std::size_t(end - p) >= length && memcmp(p, str, length) == 0);
+}
+
+// behind the next occurrence of marker or end, like the lexers skip
+static const char* skipPast(const char* p, const char* end, const char* marker, std::size_t length)
+{
+    const char* found = scan::find(p, end, marker, length);
+    return (found == end) ? end : found + length;
+}
+
+// p is behind the opening quote; returns the position behind the closing
+// one, or NULL for an unterminated string
+static const char* skipString(const char* p, const char* end)
+{
+    for (;;) {
+        const char* quote = static_cast<const char*>(memchr(p, '"', end - p));
+        if (quote == NULL) {
+            return NULL;
+        }
+
+        if (quote + 1 != end && quote[1] == '"') { // a doubled quote
+            p = quote + 2;
+            continue;
+        }
+
+        return quote + 1;
+    }
+}
+
+BlockIndex::BlockIndex() :
+    m_statementsBegin(NULL),
+    m_statementsEnd(NULL)
+{ }
+
+bool BlockIndex::build(const char* begin, const char* end)
+{
+    m_statements.clear();
+    m_statementsBegin = NULL;
+    m_statementsEnd = NULL;
+
+    const char* p = begin;
+    const char* counted = begin; // the lines are counted up to here
+    int line = 1;
+    int depth = 0;               // PROJECT is 1, MODULE 2, its blocks 3
+    bool inModule = false;
+    Block block = { NULL, NULL, 0 };
+
+    while ((p = scan::skipPlainText(p, end)) != end) {
+        if (*p == '"') {
+            p = skipString(p + 1, end);
+            if (p == NULL) return false;
+            continue;
+        }
+
+        if (startsWith(p, end, LITERAL("/*"))) {
+            p = skipPast(p + 2, end, LITERAL("*/"));
+            continue;
+        }
+
+        bool opening = startsWith(p, end, LITERAL("/begin"));
+        if (!opening && !startsWith(p, end, LITERAL("/end"))) {
+            ++p;
+            continue;
+        }
+
+        const char* slash = p;
+        if (inModule && depth == 2) {
+            line += scan::countNewlines(counted, slash);
+            counted = slash;
+            block.begin = slash;
+            block.line = line;
+            block.keyword = std::string_view();
+            block.name = std::string_view();
+        }
+
+        // skipped as a whole, so they may contain anything
+        if (startsWith(p, end, LITERAL("/begin A2ML"))) {
+            p = skipPast(p, end, LITERAL("/end A2ML"));
+        }
+        else if (startsWith(p, end, LITERAL("/begin IF_DATA"))) {
+            p = skipPast(p, end, LITERAL("/end IF_DATA"));
+        }
+        else {
+            int lines = 0; // counted lazily above
+            const char* keyword = scan::skipWhitespace(p + (opening ? 6 : 4), end, lines);
+            p = scan::skipIdentifier(keyword, end);
+            std::string_view name(keyword, p - keyword);
+
+            if (opening) {
+                ++depth;
+                if (depth == 2 && name == "MODULE") {
+                    inModule = true;
+                }
+                else if (inModule && depth == 3) { // the name follows the keyword
+                    const char* id = scan::skipWhitespace(p, end, lines);
+                    block.keyword = name;
+                    block.name = std::string_view(id, scan::skipIdentifier(id, end) - id);
+                }
+                continue;
+            }
+
+            --depth;
+            if (depth < 0) return false;
+
+            if (inModule && depth == 1) { // "/end MODULE"
+                m_statementsEnd = slash;
+                inModule = false;
+                continue;
+            }
+
+            if (!inModule || depth != 2) continue;
+
+            if (m_statementsBegin == NULL) {
+                if (name == "MOD_COMMON") m_statementsBegin = p;
+                continue;
+            }
+        }
+
+        if (inModule && depth == 2 && m_statementsBegin != NULL) {
+            block.end = p;
+            m_statements.push_back(block);
+        }
+    }
+
+    return (depth == 0 && m_statementsBegin != NULL && m_statementsEnd != NULL);
+}
@@ -0,0 +1,56 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Positions of the top-level blocks inside the MODULE of an A2L file. The
+// index is built without tokenizing the input: only strings, comments and
+// the A2ML and IF_DATA blocks, which the lexers skip, have to be recognized
+// to match each /begin with its /end.
+class BlockIndex
+{
+public:
+    struct Block
+    {
+        const char* begin; // at "/begin"
+        const char* end;   // behind the keyword of the matching "/end"
+        int line;          // of begin
+
+        std::string_view keyword; // e.g. CHARACTERISTIC, empty for A2ML and IF_DATA
+        std::string_view name;    // the identifier behind the keyword
+    };
+
+    BlockIndex();
+
+    // false if [begin, end) does not have the PROJECT/MODULE structure
+    bool build(const char* begin, const char* end);
+
+    // The statements of the MODULE: all of its blocks behind MOD_COMMON.
+    // They are the only part of the input between statementsBegin() and
+    // statementsEnd(), apart from whitespace and comments.
+    const std::vector<Block>& statements() const { return m_statements; }
+    const char* statementsBegin() const { return m_statementsBegin; }
+    const char* statementsEnd() const { return m_statementsEnd; }
+
+private:
+    std::vector<Block> m_statements;
+    const char* m_statementsBegin; // behind "/end MOD_COMMON"
+    const char* m_statementsEnd;   // at "/end MODULE"
+};
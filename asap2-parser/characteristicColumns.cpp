@@ -0,0 +1,125 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "characteristicColumns.h"
+#include "node.h"
+
+namespace {
+
+// the axis lengths, 0 for axes a characteristic does not have
+struct AxisLengths
+{
+    int x, y;
+
+    template<class Axis>
+    void operator()(NMap<Axis>& map) { x = map.m_axis_1->length; y = map.m_axis_2->length; }
+    void operator()(NCurve& curve) { x = curve.m_axis_1.get() ? curve.m_axis_1->length : 0; y = 0; }
+    void operator()(NCharacteristic& other) { x = y = 0; }
+};
+
+} // namespace
+
+CharacteristicColumns::CharacteristicColumns(const NModule& module)
+{
+    module.loadAll(CharacteristicObject);
+
+    std::size_t count = module.characteristics.size();
+    m_objects.reserve(count);
+    m_kind.reserve(count);
+    m_address.reserve(count);
+    m_recordLayout.reserve(count);
+    m_compuMethod.reserve(count);
+    m_min.reserve(count);
+    m_max.reserve(count);
+    m_scale.reserve(count);
+    m_axisXlength.reserve(count);
+    m_axisYlength.reserve(count);
+
+    BOOST_FOREACH(CharacteristicHashMap::value_type i, module.characteristics) {
+        NCharacteristic* characteristic = i.second;
+
+        AxisLengths lengths;
+        dispatchCharacteristic(*characteristic, lengths);
+
+        m_objects.push_back(characteristic);
+        m_kind.push_back(characteristic->kind);
+        m_address.push_back(characteristic->address);
+        m_recordLayout.push_back(characteristic->recordLayout);
+        m_compuMethod.push_back(characteristic->compuMethod);
+        m_min.push_back(characteristic->min);
+        m_max.push_back(characteristic->max);
+        m_scale.push_back(characteristic->scale);
+        m_axisXlength.push_back(lengths.x);
+        m_axisYlength.push_back(lengths.y);
+    }
+}
+
+std::size_t CharacteristicColumns::memoryUsage() const
+{
+    return m_objects.capacity() * sizeof(NCharacteristic*)
+        + m_kind.capacity() * sizeof(boost::uint8_t)
+        + m_address.capacity() * sizeof(unsigned long)
+        + (m_recordLayout.capacity() + m_compuMethod.capacity()) * sizeof(Symbol)
+        + (m_min.capacity() + m_max.capacity() + m_scale.capacity()) * sizeof(double)
+        + (m_axisXlength.capacity() + m_axisYlength.capacity()) * sizeof(int);
+}
+
+// The scans write every row and advance only over the hits, so the loops
+// have no branch which depends on the data.
+
+void CharacteristicColumns::selectAddresses(unsigned long begin, unsigned long end, unsigned kinds, RowList& rows) const
+{
+    std::size_t count = size();
+    std::size_t n = rows.size();
+    rows.resize(n + count);
+
+    const unsigned long* address = m_address.data();
+    const boost::uint8_t* kind = m_kind.data();
+    Row* out = rows.data() + n;
+    for (std::size_t i = 0; i < count; ++i) {
+        out[0] = Row(i);
+        out += (address[i] >= begin) & (address[i] < end) & ((kinds >> kind[i]) & 1);
+    }
+
+    rows.resize(out - rows.data());
+}
+
+void CharacteristicColumns::selectSymbol(const std::vector<Symbol>& column, Symbol value, unsigned kinds, RowList& rows) const
+{
+    std::size_t count = size();
+    std::size_t n = rows.size();
+    rows.resize(n + count);
+
+    const Symbol* symbol = column.data();
+    const boost::uint8_t* kind = m_kind.data();
+    Row* out = rows.data() + n;
+    for (std::size_t i = 0; i < count; ++i) {
+        out[0] = Row(i);
+        out += (symbol[i] == value) & ((kinds >> kind[i]) & 1);
+    }
+
+    rows.resize(out - rows.data());
+}
+
+void CharacteristicColumns::selectCompuMethod(Symbol compuMethod, unsigned kinds, RowList& rows) const
+{
+    selectSymbol(m_compuMethod, compuMethod, kinds, rows);
+}
+
+void CharacteristicColumns::selectRecordLayout(Symbol recordLayout, unsigned kinds, RowList& rows) const
+{
+    selectSymbol(m_recordLayout, recordLayout, kinds, rows);
+}
@@ -0,0 +1,80 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+#include "node.h"
+
+// a mask of all CharacteristicKinds
+const unsigned AllKinds = (1 << MapKind) | (1 << CurveKind) | (1 << ValueKind)
+                        | (1 << ValBlkKind) | (1 << AsciiKind);
+
+// The characteristics of a module as one array per property, in the order
+// of the module's map. Scans over a property touch only its array and run
+// without virtual calls, the rows lead back to the nodes.
+//
+// The columns are a snapshot; they have to be built again when the module
+// changes.
+class CharacteristicColumns
+{
+public:
+    typedef boost::uint32_t Row;
+    typedef std::vector<Row> RowList;
+
+    // loads all characteristics of a lazily parsed module
+    explicit CharacteristicColumns(const NModule& module);
+
+    std::size_t size() const { return m_objects.size(); }
+
+    // the bytes of the columns
+    std::size_t memoryUsage() const;
+
+    NCharacteristic* object(Row row) const { return m_objects[row]; }
+    CharacteristicKind kind(Row row) const { return CharacteristicKind(m_kind[row]); }
+    unsigned long address(Row row) const { return m_address[row]; }
+    Symbol recordLayout(Row row) const { return m_recordLayout[row]; }
+    Symbol compuMethod(Row row) const { return m_compuMethod[row]; }
+    double min(Row row) const { return m_min[row]; }
+    double max(Row row) const { return m_max[row]; }
+    double scale(Row row) const { return m_scale[row]; }
+    int axisXlength(Row row) const { return m_axisXlength[row]; }
+    int axisYlength(Row row) const { return m_axisYlength[row]; }
+
+    // The rows of the kinds in the mask with an address in [begin, end),
+    // appended to rows.
+    void selectAddresses(unsigned long begin, unsigned long end, unsigned kinds, RowList& rows) const;
+
+    void selectCompuMethod(Symbol compuMethod, unsigned kinds, RowList& rows) const;
+    void selectRecordLayout(Symbol recordLayout, unsigned kinds, RowList& rows) const;
+
+private:
+    void selectSymbol(const std::vector<Symbol>& column, Symbol value, unsigned kinds, RowList& rows) const;
+
+    std::vector<NCharacteristic*> m_objects;
+    std::vector<boost::uint8_t> m_kind;
+    std::vector<unsigned long> m_address;
+    std::vector<Symbol> m_recordLayout;
+    std::vector<Symbol> m_compuMethod;
+    std::vector<double> m_min;
+    std::vector<double> m_max;
+    std::vector<double> m_scale;
+    std::vector<int> m_axisXlength; // 0 if there is no such axis
+    std::vector<int> m_axisYlength;
+};
@@ -0,0 +1,138 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
+#include "crossReference.h"
+
+namespace {
+
+struct Entry
+{
+    int table; // which RangeMap
+    Symbol object;
+    CrossReference::Reference reference;
+};
+
+// groups the entries by table and object; stable, so each group keeps the
+// order of the functions
+bool groupOrder(const Entry& a, const Entry& b)
+{
+    return (a.table != b.table) ? a.table < b.table : a.object < b.object;
+}
+
+enum { Characteristics, Measurements, SubFunctions };
+
+void addList(std::vector<Entry>& entries, int table, const SymbolList* list,
+             Symbol function, int category, CrossReference::Role role)
+{
+    if (list == NULL) return;
+
+    BOOST_FOREACH(Symbol object, *list) {
+        Entry entry = { table, object, { function, category, role } };
+        entries.push_back(entry);
+    }
+}
+
+} // namespace
+
+CrossReference::CrossReference(const NModule& module)
+{
+    int position = 0;
+    BOOST_FOREACH(FunctionHashMap::value_type i, module.functions) {
+        m_categories[i.first] = position++;
+    }
+
+    std::vector<Entry> entries;
+    BOOST_FOREACH(FunctionHashMap::value_type i, module.functions) {
+        const NFunction& function = *i.second;
+        int own = m_categories[i.first];
+
+        addList(entries, Characteristics, function.def_characteristic, i.first, own, DefCharacteristic);
+        addList(entries, Characteristics, function.ref_characteristic, i.first, own, RefCharacteristic);
+        addList(entries, Measurements, function.in_measurement, i.first, own, InMeasurement);
+        addList(entries, Measurements, function.out_measurement, i.first, own, OutMeasurement);
+        addList(entries, Measurements, function.loc_measurement, i.first, own, LocMeasurement);
+
+        if (function.sub_function != NULL) {
+            BOOST_FOREACH(Symbol sub, *function.sub_function) {
+                Entry entry = { SubFunctions, i.first, { sub, category(sub), SubFunction } };
+                entries.push_back(entry);
+            }
+        }
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), groupOrder);
+
+    RangeMap* tables[] = { &m_characteristics, &m_measurements, &m_subFunctions };
+    m_references.reserve(entries.size());
+    for (std::size_t begin = 0; begin != entries.size(); ) {
+        std::size_t end = begin;
+        for (; end != entries.size() && !groupOrder(entries[begin], entries[end]); ++end) {
+            m_references.push_back(entries[end].reference);
+        }
+
+        (*tables[entries[begin].table])[entries[begin].object] = std::make_pair(begin, end);
+        begin = end;
+    }
+}
+
+int CrossReference::category(Symbol function) const
+{
+    boost::unordered_map<Symbol, int>::const_iterator i = m_categories.find(function);
+    return (i != m_categories.end()) ? i->second : -1;
+}
+
+CrossReference::Range CrossReference::find(const RangeMap& ranges, Symbol id) const
+{
+    RangeMap::const_iterator i = ranges.find(id);
+    if (i == ranges.end()) {
+        return Range(NULL, NULL);
+    }
+
+    const Reference* references = m_references.data();
+    return Range(references + i->second.first, references + i->second.second);
+}
+
+namespace {
+
+// a node per entry with its next pointer and cached hash, and a bucket
+template<class Map>
+std::size_t mapUsage(const Map& map)
+{
+    return map.size() * (sizeof(typename Map::value_type) + 2 * sizeof(void*))
+        + map.bucket_count() * sizeof(void*);
+}
+
+} // namespace
+
+std::size_t CrossReference::memoryUsage() const
+{
+    return mapUsage(m_characteristics) + mapUsage(m_measurements) + mapUsage(m_subFunctions)
+        + mapUsage(m_categories) + m_references.capacity() * sizeof(Reference);
+}
+
+const char* CrossReference::roleName(Role role)
+{
+    static const char* const names[] = {
+        "DEF_CHARACTERISTIC", "REF_CHARACTERISTIC",
+        "IN_MEASUREMENT", "OUT_MEASUREMENT", "LOC_MEASUREMENT",
+        "SUB_FUNCTION"
+    };
+    return names[role];
+}
@@ -0,0 +1,84 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include <boost/unordered_map.hpp>
+
+#include "node.h"
+
+// Who refers to whom among the FUNCTIONs of a module, built once from
+// their lists: the functions which list a characteristic or a measurement,
+// and the sub-functions of each function. Every reference carries the
+// index of the XDF CATEGORY of the function it names, which is the
+// position of the function in the module's map.
+//
+// The index is a snapshot; it has to be built again when the module
+// changes.
+class CrossReference
+{
+public:
+    // the list of a FUNCTION the reference comes from
+    enum Role
+    {
+        DefCharacteristic,
+        RefCharacteristic,
+        InMeasurement,
+        OutMeasurement,
+        LocMeasurement,
+        SubFunction
+    };
+
+    struct Reference
+    {
+        Symbol function; // the function which lists the object, or the sub-function
+        int category;    // of function, -1 for an unknown sub-function
+        Role role;
+    };
+
+    // consecutive references, in the order of the functions and their lists
+    typedef std::pair<const Reference*, const Reference*> Range;
+
+    explicit CrossReference(const NModule& module);
+
+    Range characteristic(Symbol id) const { return find(m_characteristics, id); }
+    Range measurement(Symbol id) const { return find(m_measurements, id); }
+    Range subFunctions(Symbol function) const { return find(m_subFunctions, function); }
+
+    // -1 if function is unknown
+    int category(Symbol function) const;
+
+    std::size_t size() const { return m_references.size(); }
+
+    // the bytes of the index, roughly
+    std::size_t memoryUsage() const;
+
+    static const char* roleName(Role role);
+
+private:
+    typedef boost::unordered_map<Symbol, std::pair<std::size_t, std::size_t> > RangeMap;
+
+    Range find(const RangeMap& ranges, Symbol id) const;
+
+    RangeMap m_characteristics;
+    RangeMap m_measurements;
+    RangeMap m_subFunctions;
+    boost::unordered_map<Symbol, int> m_categories;
+    std::vector<Reference> m_references; // grouped by the object they refer to
+};
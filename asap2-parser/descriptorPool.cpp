@@ -0,0 +1,122 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <boost/functional/hash.hpp>
+
+#include "descriptorPool.h"
+
+namespace {
+
+bool sameBits(double a, double b)
+{
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+} // namespace
+
+bool DescriptorPool::AxisKey::operator==(const AxisKey& other) const
+{
+    return style == other.style && dataType == other.dataType && compuMethod == other.compuMethod
+        && axisPts == other.axisPts && length == other.length
+        && format.length == other.format.length && format.decimalPl == other.format.decimalPl
+        && sameBits(min, other.min) && sameBits(max, other.max);
+}
+
+std::size_t DescriptorPool::AxisKeyHash::operator()(const AxisKey& key) const
+{
+    std::size_t seed = 0;
+    boost::hash_combine(seed, int(key.style));
+    boost::hash_combine(seed, key.dataType);
+    boost::hash_combine(seed, key.compuMethod);
+    boost::hash_combine(seed, key.axisPts);
+    boost::hash_combine(seed, key.length);
+    boost::hash_combine(seed, key.format.length);
+    boost::hash_combine(seed, key.format.decimalPl);
+    boost::hash_range(seed, reinterpret_cast<const char*>(&key.min), reinterpret_cast<const char*>(&key.min + 1));
+    boost::hash_range(seed, reinterpret_cast<const char*>(&key.max), reinterpret_cast<const char*>(&key.max + 1));
+    return seed;
+}
+
+std::size_t DescriptorPool::MemberKeyHash::operator()(const MemberKey& key) const
+{
+    std::size_t seed = 0;
+    boost::hash_combine(seed, key.kind);
+    boost::hash_combine(seed, key.a);
+    boost::hash_combine(seed, key.b);
+    boost::hash_combine(seed, key.c);
+    return seed;
+}
+
+template<class Axis>
+Axis* DescriptorPool::axis(const AxisKey& key, const Axis& prototype)
+{
+    ++m_requests;
+
+    NAxis*& shared = m_axes[key];
+    if (shared == NULL) {
+        shared = new (m_arena) Axis(prototype);
+    }
+    return static_cast<Axis*>(shared);
+}
+
+NStdAxis* DescriptorPool::stdAxis(Symbol dataType, Symbol compuMethod, int length, double min, double max, const Format& format)
+{
+    AxisKey key = { Intern, dataType, compuMethod, 0, length, format, min, max };
+    return axis(key, NStdAxis(dataType, compuMethod, length, min, max, format));
+}
+
+NComAxis* DescriptorPool::comAxis(Symbol dataType, Symbol compuMethod, int length, double min, double max, Symbol axisPts)
+{
+    AxisKey key = { Extern, dataType, compuMethod, axisPts, length, emptyFormat(), min, max };
+    return axis(key, NComAxis(dataType, compuMethod, length, min, max, axisPts));
+}
+
+NFixAxis* DescriptorPool::fixAxis(Symbol dataType, Symbol compuMethod, int length, double min, double max, const Format& format)
+{
+    AxisKey key = { Fixed, dataType, compuMethod, 0, length, format, min, max };
+    return axis(key, NFixAxis(dataType, compuMethod, length, min, max, format));
+}
+
+const NRecordLayout::AxisLayout* DescriptorPool::axisLayout(int noAxisType, int valAxisType, int flags)
+{
+    ++m_requests;
+
+    MemberKey key = { 0, noAxisType, valAxisType, flags };
+    const void*& shared = m_members[key];
+    if (shared == NULL) {
+        shared = new (m_arena) NRecordLayout::AxisLayout(noAxisType, valAxisType, flags);
+    }
+    return static_cast<const NRecordLayout::AxisLayout*>(shared);
+}
+
+NRecordLayout::FncValues* DescriptorPool::fncValues(int type, int flags)
+{
+    ++m_requests;
+
+    MemberKey key = { 1, type, flags, 0 };
+    const void*& shared = m_members[key];
+    if (shared == NULL) {
+        shared = new (m_arena) NRecordLayout::FncValues(type, flags);
+    }
+    return static_cast<NRecordLayout::FncValues*>(const_cast<void*>(shared));
+}
+
+void DescriptorPool::clear()
+{
+    m_axes.clear();
+    m_members.clear();
+}
@@ -0,0 +1,100 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <boost/unordered_map.hpp>
+
+#include "node.h"
+
+// Hash-consing of the small value nodes many objects repeat: axis
+// descriptors and the members of record layouts. Identical ones are
+// allocated once in the arena and shared by all the objects which use
+// them, so anything derived from them (e.g. the links, the XDF MATH
+// equation of an axis) is computed once as well.
+//
+// A shared axis is the child of all its maps; its parent is one of them.
+// The pool refers into the arena, clear() it when the arena is rewound.
+class DescriptorPool
+{
+public:
+    explicit DescriptorPool(Arena& arena) : m_arena(arena), m_requests(0) { }
+
+    NStdAxis* stdAxis(Symbol dataType, Symbol compuMethod, int length, double min, double max, const Format& format);
+    NComAxis* comAxis(Symbol dataType, Symbol compuMethod, int length, double min, double max, Symbol axisPts);
+    NFixAxis* fixAxis(Symbol dataType, Symbol compuMethod, int length, double min, double max, const Format& format);
+
+    const NRecordLayout::AxisLayout* axisLayout(int noAxisType, int valAxisType, int flags);
+    NRecordLayout::FncValues* fncValues(int type, int flags);
+
+    void clear();
+
+    // how many descriptors were asked for, and how many are stored
+    std::size_t requests() const { return m_requests; }
+    std::size_t size() const { return m_axes.size() + m_members.size(); }
+
+private:
+    // noncopyable
+    DescriptorPool(const DescriptorPool&);
+    DescriptorPool& operator=(const DescriptorPool&);
+
+    // every field of an axis; the doubles are compared bit by bit, so -0.0
+    // and 0.0 stay apart
+    struct AxisKey
+    {
+        AxisStyle style;
+        Symbol dataType;
+        Symbol compuMethod;
+        Symbol axisPts;
+        int length;
+        Format format;
+        double min;
+        double max;
+
+        bool operator==(const AxisKey& other) const;
+    };
+
+    struct AxisKeyHash
+    {
+        std::size_t operator()(const AxisKey& key) const;
+    };
+
+    // AxisLayout and FncValues; kind tells them apart
+    struct MemberKey
+    {
+        int kind;
+        int a, b, c;
+
+        bool operator==(const MemberKey& other) const
+        {
+            return kind == other.kind && a == other.a && b == other.b && c == other.c;
+        }
+    };
+
+    struct MemberKeyHash
+    {
+        std::size_t operator()(const MemberKey& key) const;
+    };
+
+    template<class Axis>
+    Axis* axis(const AxisKey& key, const Axis& prototype);
+
+    Arena& m_arena;
+    boost::unordered_map<AxisKey, NAxis*, AxisKeyHash> m_axes;
+    boost::unordered_map<MemberKey, const void*, MemberKeyHash> m_members;
+    std::size_t m_requests;
+};
@@ -0,0 +1,203 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "node.h"
+#include "parser.hpp"
+#include "keywords.h"
+#include "scan.hpp"
+#include "lexer.h"
+#include "fastLexer.h"
+
+#define LITERAL(str) str, sizeof(str) - 1
+
+FastLexer::FastLexer() :
+    m_pos(0),
+    m_end(0),
+    m_line(1)
+{ }
+
+void FastLexer::reset(const char* begin, const char* end, int line)
+{
+    m_pos = begin;
+    m_end = end;
+    m_line = line;
+}
+
+int FastLexer::lex(YYSTYPE* value)
+{
+    int token;
+    do {
+        m_pos = scan::skipWhitespace(m_pos, m_end, m_line);
+        if (m_pos == m_end) {
+            return 0;
+        }
+
+        token = lexToken(value);
+    } while (token == Skipped);
+
+    return token;
+}
+
+int FastLexer::lexToken(YYSTYPE* value)
+{
+    const char* start = m_pos;
+    char c = *m_pos;
+
+    if (scan::isIdentStart(c)) {
+        m_pos = scan::skipIdentifier(m_pos + 1, m_end);
+
+        int token = lookupKeyword(start, m_pos - start);
+        if (token != 0) {
+            value->token = token;
+            return token;
+        }
+
+        value->string = makeStringRef(start, m_pos - start);
+        return TIDENTIFIER;
+    }
+
+    if (scan::isDigit(c) || c == '-') {
+        return lexNumber(value);
+    }
+
+    if (c == '"') {
+        return lexString(value);
+    }
+
+    if (c == '/') {
+        return lexSlash(value);
+    }
+
+    return unknownToken();
+}
+
+// "0x"[a-fA-F0-9_]*, (-)?[0-9]+\.[0-9]*(e[-+][0-9]*)? and (-)?[0-9]+
+int FastLexer::lexNumber(YYSTYPE* value)
+{
+    const char* start = m_pos;
+
+    if (startsWith(LITERAL("0x"))) {
+        m_pos = scan::skipHexDigits(m_pos + 2, m_end);
+        return convertNumber(TADDRESS, start, m_pos - start, value, m_line);
+    }
+
+    const char* p = m_pos;
+    if (*p == '-') ++p;
+
+    const char* digits = p;
+    p = scan::skipDigits(p, m_end);
+    if (p == digits) {
+        return unknownToken(); // a lone '-'
+    }
+
+    int token = TINTEGER;
+    if (p != m_end && *p == '.') {
+        token = TDOUBLE;
+        p = scan::skipDigits(p + 1, m_end);
+
+        if (m_end - p >= 2 && p[0] == 'e' && (p[1] == '-' || p[1] == '+')) {
+            p = scan::skipDigits(p + 2, m_end);
+        }
+    }
+
+    m_pos = p;
+    return convertNumber(token, start, m_pos - start, value, m_line);
+}
+
+// \"([^\"]|\"\")*\", a doubled quote does not terminate the string
+int FastLexer::lexString(YYSTYPE* value)
+{
+    const char* start = m_pos + 1;
+    const char* p = start;
+
+    for (;;) {
+        const char* quote = static_cast<const char*>(memchr(p, '"', m_end - p));
+        if (quote == 0) {
+            return unknownToken(); // unterminated string
+        }
+
+        if (quote + 1 != m_end && quote[1] == '"') {
+            p = quote + 2;
+            continue;
+        }
+
+        m_line += scan::countNewlines(start, quote);
+        m_pos = quote + 1;
+        value->string = makeStringRef(start, quote - start);
+        return TSTRING;
+    }
+}
+
+// comments, skipped blocks, /begin and /end
+int FastLexer::lexSlash(YYSTYPE* value)
+{
+    if (startsWith(LITERAL("/*"))) {
+        m_pos += 2;
+        skipPast(LITERAL("*/"));
+        return Skipped;
+    }
+
+    if (startsWith(LITERAL("/begin A2ML"))) {
+        m_pos += sizeof("/begin A2ML") - 1;
+        skipPast(LITERAL("/end A2ML"));
+        return Skipped;
+    }
+
+    if (startsWith(LITERAL("/begin IF_DATA"))) {
+        m_pos += sizeof("/begin IF_DATA") - 1;
+        skipPast(LITERAL("/end IF_DATA"));
+        return Skipped;
+    }
+
+    if (startsWith(LITERAL("/begin"))) {
+        m_pos += sizeof("/begin") - 1;
+        value->token = TLBRACE;
+        return TLBRACE;
+    }
+
+    if (startsWith(LITERAL("/end"))) {
+        m_pos += sizeof("/end") - 1;
+        value->token = TRBRACE;
+        return TRBRACE;
+    }
+
+    return unknownToken();
+}
+
+int FastLexer::unknownToken()
+{
+    fprintf(stderr, "Unknown token at line %d!\n", m_line);
+    m_pos = m_end; // like yyterminate()
+    return 0;
+}
+
+bool FastLexer::startsWith(const char* str, std::size_t length) const
+{
+    return (std::size_t(m_end - m_pos) >= length && memcmp(m_pos, str, length) == 0);
+}
+
+// moves behind the next occurrence of marker; a missing marker skips
+// everything, like the flex scanner does
+void FastLexer::skipPast(const char* marker, std::size_t length)
+{
+    const char* found = scan::find(m_pos, m_end, marker, length);
+
+    m_line += scan::countNewlines(m_pos, found);
+    m_pos = (found == m_end) ? m_end : found + length;
+}
@@ -0,0 +1,56 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+union YYSTYPE;
+
+// Hand-written replacement for the flex scanner in tokens.l. It produces the
+// same token ids and semantic values, but skips whitespace, identifiers and
+// numbers with SSE2 character class masks (see scan.hpp) and looks up
+// keywords in the perfect hash from keywords.cpp.
+// Unlike the flex scanner it keeps all of its state in the object.
+class FastLexer
+{
+public:
+    FastLexer();
+
+    // line is the line number of begin
+    void reset(const char* begin, const char* end, int line = 1);
+
+    // returns the next token id and fills value; 0 marks the end of input
+    int lex(YYSTYPE* value);
+
+    int lineNo() const { return m_line; }
+
+private:
+    enum { Skipped = -1 }; // returned for comments and ignored blocks
+
+    int lexToken(YYSTYPE* value);
+    int lexSlash(YYSTYPE* value);
+    int lexNumber(YYSTYPE* value);
+    int lexString(YYSTYPE* value);
+    int unknownToken();
+
+    bool startsWith(const char* str, std::size_t length) const;
+    void skipPast(const char* marker, std::size_t length);
+
+    const char* m_pos;
+    const char* m_end;
+    int m_line;
+};
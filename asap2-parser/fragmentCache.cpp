@@ -0,0 +1,223 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <boost/foreach.hpp>
+
+#include "fragmentCache.h"
+
+using boost::uint32_t;
+using boost::uint64_t;
+
+namespace {
+
+// The file starts with a FileHeader and the entries, ordered by key,
+// followed by the text of the fragments.
+const char Magic[8] = { 'X', 'D', 'F', 'F', 'R', 'A', 'G', 'S' };
+const uint32_t Version = 1;
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t count;
+};
+
+// a fragment which is stored by save()
+struct Stored
+{
+    uint64_t key;
+    const char* text;
+    std::size_t length;
+
+    bool operator<(const Stored& other) const { return key < other.key; }
+};
+
+} // namespace
+
+FragmentCache::FragmentCache() :
+    m_data(NULL),
+    m_size(0),
+    m_entries(NULL),
+    m_count(0),
+    m_hits(0)
+{ }
+
+FragmentCache::~FragmentCache()
+{
+    unmap();
+}
+
+void FragmentCache::unmap()
+{
+    if (m_data != NULL) munmap(const_cast<char*>(m_data), m_size);
+
+    m_data = NULL;
+    m_size = 0;
+    m_entries = NULL;
+    m_count = 0;
+    m_used.clear();
+}
+
+bool FragmentCache::load(const std::string& path)
+{
+    unmap();
+    m_added.clear();
+    m_hits = 0;
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false; // there is no cache yet
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || std::size_t(info.st_size) < sizeof(FileHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void* p = mmap(0, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (p == MAP_FAILED) {
+        std::cerr << "Unable to map " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    m_data = static_cast<const char*>(p);
+    m_size = info.st_size;
+
+    const FileHeader& header = *reinterpret_cast<const FileHeader*>(m_data);
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version
+            || header.headerSize != sizeof(FileHeader)
+            || header.count > (m_size - sizeof(FileHeader)) / sizeof(Entry)) {
+        std::cerr << "Ignoring the damaged fragment cache " << path << std::endl;
+        unmap();
+        return false;
+    }
+
+    const Entry* entries = reinterpret_cast<const Entry*>(m_data + sizeof(FileHeader));
+    for (uint64_t i = 0; i < header.count; ++i) {
+        if (entries[i].offset > m_size || entries[i].length > m_size - entries[i].offset
+                || (i != 0 && entries[i - 1].key >= entries[i].key)) {
+            std::cerr << "Ignoring the damaged fragment cache " << path << std::endl;
+            unmap();
+            return false;
+        }
+    }
+
+    m_entries = entries;
+    m_count = header.count;
+    m_used.assign(m_count, 0);
+    return true;
+}
+
+bool FragmentCache::find(uint64_t key, std::streambuf& out)
+{
+    const Entry* end = m_entries + m_count;
+    const Entry* entry = std::lower_bound(m_entries, end, key,
+        [](const Entry& e, uint64_t key) { return e.key < key; });
+
+    if (entry != end && entry->key == key) {
+        m_used[entry - m_entries] = 1;
+        out.sputn(m_data + entry->offset, entry->length);
+        ++m_hits;
+        return true;
+    }
+
+    // rendered by this run already, e.g. when a name is selected twice
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FragmentMap::const_iterator i = m_added.find(key);
+    if (i == m_added.end()) return false;
+
+    out.sputn(i->second.data(), i->second.size());
+    ++m_hits;
+    return true;
+}
+
+void FragmentCache::insert(uint64_t key, const char* begin, const char* end)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_added[key].assign(begin, end);
+}
+
+bool FragmentCache::save(const std::string& path)
+{
+    std::vector<Stored> stored;
+    for (std::size_t i = 0; i < m_count; ++i) {
+        if (!m_used[i] || m_added.count(m_entries[i].key) != 0) continue;
+        Stored fragment = { m_entries[i].key, m_data + m_entries[i].offset, std::size_t(m_entries[i].length) };
+        stored.push_back(fragment);
+    }
+    BOOST_FOREACH (const FragmentMap::value_type& added, m_added) {
+        Stored fragment = { added.first, added.second.data(), added.second.size() };
+        stored.push_back(fragment);
+    }
+    std::sort(stored.begin(), stored.end());
+
+    FileHeader header = FileHeader();
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.headerSize = sizeof(FileHeader);
+    header.count = stored.size();
+
+    std::vector<Entry> entries;
+    entries.reserve(stored.size());
+    uint64_t offset = sizeof(FileHeader) + stored.size() * sizeof(Entry);
+    BOOST_FOREACH (const Stored& fragment, stored) {
+        Entry entry = { fragment.key, offset, fragment.length };
+        entries.push_back(entry);
+        offset += fragment.length;
+    }
+
+    // written under a temporary name, readers never see a partial file
+    std::string temporary = path + ".tmp" + std::to_string(getpid());
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == NULL) {
+        std::cerr << "Unable to create " << temporary << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+    if (ok && !entries.empty()) {
+        ok = (fwrite(&entries[0], sizeof(Entry), entries.size(), file) == entries.size());
+    }
+    for (std::size_t i = 0; ok && i < stored.size(); ++i) {
+        ok = (fwrite(stored[i].text, 1, stored[i].length, file) == stored[i].length);
+    }
+
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+        std::cerr << "Unable to write " << path << ": " << strerror(errno) << std::endl;
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    // releases the texts of stored
+    return load(path);
+}
@@ -0,0 +1,86 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+// The rendered XDFTABLEs of an earlier conversion, stored in a file. Every
+// fragment is found by the key of its characteristic, a hash of everything
+// the table is rendered from (see XdfGen::fragmentKey()), so generateXdf()
+// renders only the characteristics which changed since and copies the
+// others. The file is memory-mapped read-only.
+//
+// find() and insert() may be called by several threads at once.
+class FragmentCache
+{
+public:
+    FragmentCache();
+    ~FragmentCache();
+
+    // Uses the fragments stored in path. Returns false if there is no
+    // usable file; the cache is empty then.
+    bool load(const std::string& path);
+
+    // Stores the fragments found or inserted since load() in path, the
+    // others are dropped. The file is replaced atomically and loaded again.
+    // Returns false on errors.
+    bool save(const std::string& path);
+
+    // appends the fragment of key to out, false if there is none
+    bool find(boost::uint64_t key, std::streambuf& out);
+
+    void insert(boost::uint64_t key, const char* begin, const char* end);
+
+    // fragments found and inserted since load()
+    std::size_t hits() const { return m_hits; }
+    std::size_t inserted() const { return m_added.size(); }
+
+private:
+    // noncopyable
+    FragmentCache(const FragmentCache&);
+    FragmentCache& operator=(const FragmentCache&);
+
+    struct Entry
+    {
+        boost::uint64_t key;
+        boost::uint64_t offset; // of the text, from the start of the file
+        boost::uint64_t length;
+    };
+
+    typedef boost::unordered_map<boost::uint64_t, std::string> FragmentMap;
+
+    void unmap();
+
+    const char* m_data;
+    std::size_t m_size;
+    const Entry* m_entries; // in m_data, ordered by key
+    std::size_t m_count;
+    std::vector<char> m_used; // of each entry, not vector<bool> so threads can set them
+    std::atomic<std::size_t> m_hits;
+
+    std::mutex m_mutex; // for m_added
+    FragmentMap m_added;
+};
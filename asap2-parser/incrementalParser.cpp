@@ -0,0 +1,165 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/foreach.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "arena.h"
+#include "descriptorPool.h"
+#include "node.h"
+#include "util.h"
+#include "inputBuffer.h"
+#include "blockIndex.h"
+#include "parse.h"
+#include "linker.h"
+#include "incrementalParser.h"
+
+static boost::uint64_t skeletonHash(const InputBuffer& input, const BlockIndex& index)
+{
+    return contentHash(input.begin(), index.statementsBegin())
+        ^ (contentHash(index.statementsEnd(), input.end()) * 31);
+}
+
+struct IncrementalParser::Generation
+{
+    Arena arena;
+    DescriptorPool descriptors; // shared by all the versions of the nodes
+
+    Generation() : descriptors(arena) { }
+};
+
+IncrementalParser::IncrementalParser(LexerBackend backend) :
+    m_backend(backend),
+    m_project(NULL),
+    m_skeletonHash(0),
+    m_parsedBlocks(0),
+    m_replacedBytes(0)
+{ }
+
+IncrementalParser::~IncrementalParser()
+{ }
+
+NProject* IncrementalParser::parse(const InputBuffer& input)
+{
+    BlockIndex index;
+    if (!index.build(input.begin(), input.end())) {
+        std::cerr << "Unable to find the blocks of the MODULE" << std::endl;
+        return NULL;
+    }
+
+    // the previous project is kept until this one is complete
+    std::unique_ptr<Generation> generation(new Generation());
+    NProject* project = parseSkeleton(input, index, generation->arena, m_backend);
+    if (project == NULL) {
+        return NULL;
+    }
+
+    std::vector<ParsedBlock> blocks;
+    blocks.reserve(index.statements().size());
+
+    NModule& module = project->m_module.ref();
+    BOOST_FOREACH(const BlockIndex::Block& block, index.statements()) {
+        NBlock* statements = parseStatements(block.begin, block.end, block.line, generation->arena, m_backend,
+                                             &generation->descriptors);
+        if (statements == NULL) {
+            return NULL;
+        }
+
+        ParsedBlock parsed = { contentHash(block.begin, block.end), std::size_t(block.end - block.begin), statements };
+        blocks.push_back(parsed);
+        module.addStatements(statements->statements);
+    }
+
+    linkModule(module);
+
+    m_generation.swap(generation); // releases the previous nodes
+    m_project = project;
+    m_skeletonHash = skeletonHash(input, index);
+    m_blocks.swap(blocks);
+    m_parsedBlocks = m_blocks.size();
+    m_replacedBytes = 0;
+    return m_project;
+}
+
+NProject* IncrementalParser::update(const InputBuffer& input)
+{
+    BlockIndex index;
+    if (m_project == NULL || !index.build(input.begin(), input.end())
+            || skeletonHash(input, index) != m_skeletonHash || m_replacedBytes > input.size()) {
+        return parse(input);
+    }
+
+    // the previous blocks by content; equal blocks are matched in order
+    typedef boost::unordered_multimap<boost::uint64_t, std::size_t> BlockMap;
+    BlockMap previous;
+    for (std::size_t i = 0; i < m_blocks.size(); ++i) {
+        previous.insert(BlockMap::value_type(m_blocks[i].hash, i));
+    }
+
+    std::vector<ParsedBlock> blocks;
+    blocks.reserve(index.statements().size());
+    std::vector<bool> kept(m_blocks.size(), false);
+    std::vector<NBlock*> added;
+    std::size_t addedBytes = 0;
+
+    BOOST_FOREACH(const BlockIndex::Block& block, index.statements()) {
+        ParsedBlock parsed = { contentHash(block.begin, block.end), std::size_t(block.end - block.begin), NULL };
+
+        std::pair<BlockMap::iterator, BlockMap::iterator> range = previous.equal_range(parsed.hash);
+        for (BlockMap::iterator i = range.first; i != range.second; ++i) {
+            if (m_blocks[i->second].length == parsed.length) {
+                parsed.statements = m_blocks[i->second].statements;
+                kept[i->second] = true;
+                previous.erase(i);
+                break;
+            }
+        }
+
+        if (parsed.statements == NULL) {
+            parsed.statements = parseStatements(block.begin, block.end, block.line, m_generation->arena, m_backend,
+                                                &m_generation->descriptors);
+            if (parsed.statements == NULL) {
+                m_replacedBytes += addedBytes; // nothing else is changed
+                return NULL;
+            }
+            added.push_back(parsed.statements);
+            addedBytes += parsed.length;
+        }
+
+        blocks.push_back(parsed);
+    }
+
+    NModule& module = m_project->m_module.ref();
+    for (std::size_t i = 0; i < m_blocks.size(); ++i) {
+        if (!kept[i]) m_replacedBytes += m_blocks[i].length;
+    }
+
+    StatementList& inner = module.m_innerBlock->statements;
+    inner.clear();
+    BOOST_FOREACH(const ParsedBlock& parsed, blocks) {
+        inner.insert(inner.end(), parsed.statements->statements.begin(), parsed.statements->statements.end());
+    }
+
+    // in input order, so the objects are listed like after a complete parse
+    module.rebuildMaps();
+
+    // unchanged objects may refer to replaced ones
+    linkModule(module);
+
+    m_blocks.swap(blocks);
+    m_parsedBlocks = added.size();
+    return m_project;
+}
@@ -0,0 +1,82 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <boost/cstdint.hpp>
+
+#include "lexer.h"
+
+class InputBuffer;
+class NProject;
+class NBlock;
+
+// Keeps a parsed project up to date with an edited file. Every statement
+// of the MODULE remembers the hash of its /begin-/end block; an update
+// parses only the blocks which are not found among the previous ones and
+// fills the maps of the MODULE again, in input order.
+//
+// The nodes do not refer to the input, so each version of the file can be
+// released after it was parsed. The parser owns the nodes: a complete
+// parse builds them in a new arena and releases the previous one. Replaced
+// nodes stay until then, so once the replaced blocks add up to the size of
+// the input, update() parses the whole file again.
+class IncrementalParser
+{
+public:
+    explicit IncrementalParser(LexerBackend backend);
+    ~IncrementalParser();
+
+    // A complete parse, NULL on errors. The project stays valid until the
+    // next successful parse() or update().
+    NProject* parse(const InputBuffer& input);
+
+    // Brings the project up to date with input, a new version of the file
+    // parsed last. Falls back to a complete parse if anything outside of the
+    // MODULE body changed. Returns NULL on errors; the previous project is
+    // left unchanged then.
+    NProject* update(const InputBuffer& input);
+
+    // blocks parsed by the last parse() or update()
+    std::size_t parsedBlocks() const { return m_parsedBlocks; }
+    std::size_t totalBlocks() const { return m_blocks.size(); }
+
+private:
+    // noncopyable
+    IncrementalParser(const IncrementalParser&);
+    IncrementalParser& operator=(const IncrementalParser&);
+
+    struct ParsedBlock
+    {
+        boost::uint64_t hash;
+        std::size_t length;
+        NBlock* statements; // usually one
+    };
+
+    // the arena of the nodes, with the axes they share
+    struct Generation;
+
+    LexerBackend m_backend;
+    std::unique_ptr<Generation> m_generation; // of m_project
+    NProject* m_project;
+    boost::uint64_t m_skeletonHash;
+    std::vector<ParsedBlock> m_blocks; // in input order
+    std::size_t m_parsedBlocks;
+    std::size_t m_replacedBytes; // of the blocks replaced since the last parse()
+};
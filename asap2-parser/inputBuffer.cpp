@@ -0,0 +1,109 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "inputBuffer.h"
+
+InputBuffer::InputBuffer() :
+    m_data(0),
+    m_size(0),
+    m_mapped(false)
+{ }
+
+InputBuffer::~InputBuffer()
+{
+    release();
+}
+
+void InputBuffer::release()
+{
+    if (m_mapped) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+
+    m_storage.clear();
+    m_data = 0;
+    m_size = 0;
+    m_mapped = false;
+}
+
+bool InputBuffer::mapFile(const char* path)
+{
+    release();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Unable to open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        std::cerr << "Unable to stat " << path << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    if (info.st_size == 0) { // mmap refuses empty mappings
+        close(fd);
+        m_data = "";
+        return true;
+    }
+
+    void* p = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps its own reference
+
+    if (p == MAP_FAILED) {
+        std::cerr << "Unable to map " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    madvise(p, info.st_size, MADV_SEQUENTIAL); // the lexer reads front to back
+
+    m_data = static_cast<const char*>(p);
+    m_size = info.st_size;
+    m_mapped = true;
+    return true;
+}
+
+bool InputBuffer::readStream(FILE* stream)
+{
+    release();
+
+    char chunk[64 * 1024];
+    std::size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), stream)) > 0) {
+        m_storage.insert(m_storage.end(), chunk, chunk + n);
+    }
+
+    if (ferror(stream)) {
+        std::cerr << "Unable to read input stream!" << std::endl;
+        m_storage.clear();
+        return false;
+    }
+
+    m_data = m_storage.empty() ? "" : &m_storage[0];
+    m_size = m_storage.size();
+    return true;
+}
@@ -0,0 +1,53 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+// The whole lexer input as one contiguous, read-only block of memory.
+// Files are memory-mapped, streams (e.g. stdin) are read into memory once.
+// Tokens are handed to the parser as views into this block, so it has to
+// outlive the parse.
+class InputBuffer
+{
+public:
+    InputBuffer();
+    ~InputBuffer();
+
+    bool mapFile(const char* path);
+    bool readStream(FILE* stream);
+
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+    std::size_t size() const { return m_size; }
+
+    bool isMapped() const { return m_mapped; }
+
+private:
+    // noncopyable
+    InputBuffer(const InputBuffer&);
+    InputBuffer& operator=(const InputBuffer&);
+
+    void release();
+
+    const char* m_data;
+    std::size_t m_size;
+    bool m_mapped;
+    std::vector<char> m_storage; // used if the input could not be mapped
+};
@@ -0,0 +1,119 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "node.h"
+#include "parser.hpp"
+#include "keywords.h"
+
+// The keyword table is a perfect hash built by the compiler: the seed is
+// searched at compile time until no two keywords share a slot, so a lookup
+// is one hash over the identifier, one table load and one compare.
+namespace {
+
+struct Keyword
+{
+    const char* name;
+    std::size_t length;
+    int token;
+};
+
+constexpr Keyword keywords[] = {
+#define A2L_KEYWORD(name, token) { #name, sizeof(#name) - 1, token },
+#include "keywords.def"
+#undef A2L_KEYWORD
+};
+
+constexpr std::size_t keywordCount = sizeof(keywords) / sizeof(keywords[0]);
+constexpr std::size_t tableSize = 512; // power of two, several times keywordCount
+
+static_assert(keywordCount < 255, "slots are stored as unsigned char");
+static_assert(keywordCount * 4 < tableSize, "keyword table too small");
+
+constexpr unsigned int hashKeyword(const char* str, std::size_t length, unsigned int seed)
+{
+    unsigned int h = seed ^ static_cast<unsigned int>(length);
+    for (std::size_t i = 0; i < length; ++i) {
+        h = (h ^ static_cast<unsigned char>(str[i])) * 0x01000193u; // FNV-1a step
+    }
+
+    return h ^ (h >> 16);
+}
+
+constexpr unsigned int findSeed()
+{
+    for (unsigned int seed = 1; ; ++seed) {
+        bool used[tableSize] = { };
+        bool collision = false;
+
+        for (std::size_t i = 0; i < keywordCount && !collision; ++i) {
+            unsigned int slot = hashKeyword(keywords[i].name, keywords[i].length, seed) & (tableSize - 1);
+            collision = used[slot];
+            used[slot] = true;
+        }
+
+        if (!collision) return seed;
+    }
+}
+
+constexpr unsigned int keywordSeed = findSeed();
+
+struct KeywordTable
+{
+    unsigned char slots[tableSize]; // keyword index + 1, 0 means empty
+    std::size_t minLength;
+    std::size_t maxLength;
+};
+
+constexpr KeywordTable buildTable()
+{
+    KeywordTable table = { };
+    table.minLength = keywords[0].length;
+
+    for (std::size_t i = 0; i < keywordCount; ++i) {
+        unsigned int slot = hashKeyword(keywords[i].name, keywords[i].length, keywordSeed) & (tableSize - 1);
+        table.slots[slot] = static_cast<unsigned char>(i + 1);
+
+        if (keywords[i].length < table.minLength) table.minLength = keywords[i].length;
+        if (keywords[i].length > table.maxLength) table.maxLength = keywords[i].length;
+    }
+
+    return table;
+}
+
+constexpr KeywordTable keywordTable = buildTable();
+
+} // end namespace
+
+int lookupKeyword(const char* str, std::size_t length)
+{
+    if (length < keywordTable.minLength || length > keywordTable.maxLength) {
+        return 0;
+    }
+
+    unsigned int slot = keywordTable.slots[hashKeyword(str, length, keywordSeed) & (tableSize - 1)];
+    if (slot == 0) {
+        return 0;
+    }
+
+    const Keyword& keyword = keywords[slot - 1];
+    if (keyword.length != length || memcmp(keyword.name, str, length) != 0) {
+        return 0;
+    }
+
+    return keyword.token;
+}
@@ -0,0 +1,137 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares the throughput of the flex scanner and the hand-written FastLexer.
+ *
+ * usage: lexbench file.a2l [runs]
+ *
+ * Both backends tokenize the whole file; the token streams are compared to
+ * make sure the fast backend is a drop-in replacement.
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+
+#include "node.h"
+#include "parser.hpp"
+#include "inputBuffer.h"
+#include "lexer.h"
+
+struct Token
+{
+    int id;
+    YYSTYPE value;
+};
+
+static bool sameToken(const Token& a, const Token& b)
+{
+    if (a.id != b.id) return false;
+
+    switch (a.id) {
+    case TSTRING:
+    case TIDENTIFIER:
+        return a.value.string.length == b.value.string.length
+                && memcmp(a.value.string.data, b.value.string.data, a.value.string.length) == 0;
+    case TINTEGER:
+        return a.value.integer == b.value.integer;
+    case TDOUBLE:
+        return a.value.number == b.value.number;
+    case TADDRESS:
+        return a.value.addressValue == b.value.addressValue;
+    }
+
+    return true;
+}
+
+static double tokenize(
+    LexerBackend backend,
+    const InputBuffer& input,
+    int runs,
+    std::vector<Token>& tokens)
+{
+    typedef std::chrono::steady_clock clock;
+    double best = 0;
+
+    Lexer lexer(backend);
+    for (int run = 0; run < runs; ++run) {
+        tokens.clear();
+        lexer.reset(input.begin(), input.end());
+
+        clock::time_point start = clock::now();
+        YYSTYPE value;
+        for (int id; (id = lexer.lex(&value)) != 0; ) {
+            Token token = { id, value };
+            tokens.push_back(token);
+        }
+        double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        if (run == 0 || seconds < best) best = seconds;
+    }
+
+    return best;
+}
+
+static void report(const char* name, const InputBuffer& input, size_t tokens, double seconds)
+{
+    std::cout << name << ": " << tokens << " tokens in " << seconds << " s, "
+              << tokens / seconds << " tokens/s, "
+              << input.size() / seconds / (1024 * 1024) << " MB/s" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " file.a2l [runs]" << std::endl;
+        return -1;
+    }
+
+    int runs = (argc > 2) ? atoi(argv[2]) : 3;
+    if (runs < 1) runs = 1;
+
+    InputBuffer input;
+    if (!input.mapFile(argv[1])) {
+        return -1;
+    }
+
+    std::vector<Token> flexTokens, fastTokens;
+    flexTokens.reserve(input.size() / 4);
+    fastTokens.reserve(input.size() / 4);
+
+    double flexTime = tokenize(FlexBackend, input, runs, flexTokens);
+    double fastTime = tokenize(FastBackend, input, runs, fastTokens);
+
+    report("flex", input, flexTokens.size(), flexTime);
+    report("fast", input, fastTokens.size(), fastTime);
+    std::cout << "speedup: " << flexTime / fastTime << std::endl;
+
+    if (flexTokens.size() != fastTokens.size()) {
+        std::cerr << "token count differs!" << std::endl;
+        return 1;
+    }
+
+    for (size_t i = 0; i < flexTokens.size(); ++i) {
+        if (!sameToken(flexTokens[i], fastTokens[i])) {
+            std::cerr << "token " << i << " differs: " << flexTokens[i].id
+                      << " vs " << fastTokens[i].id << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
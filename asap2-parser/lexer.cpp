@@ -0,0 +1,125 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <limits>
+#include <charconv>
+
+#include "node.h"
+#include "parser.hpp"
+#include "fastLexer.h"
+#include "lexer.h"
+
+// implemented in tokens.l
+void* createFlexScanner();
+void destroyFlexScanner(void* scanner);
+void setFlexInput(void* scanner, const char* begin, const char* end, int line);
+int flexLex(YYSTYPE* value, void* scanner);
+int flexLineNo(void* scanner);
+
+Lexer::Lexer(LexerBackend backend) :
+    m_backend(backend),
+    m_flexScanner(backend == FlexBackend ? createFlexScanner() : NULL)
+{ }
+
+Lexer::~Lexer()
+{
+    if (m_flexScanner != NULL) {
+        destroyFlexScanner(m_flexScanner);
+    }
+}
+
+void Lexer::reset(const char* begin, const char* end, int line)
+{
+    if (m_backend == FastBackend) {
+        m_fastLexer.reset(begin, end, line);
+    }
+    else {
+        setFlexInput(m_flexScanner, begin, end, line);
+    }
+}
+
+int Lexer::lex(YYSTYPE* value)
+{
+    if (m_backend == FastBackend) {
+        return m_fastLexer.lex(value);
+    }
+
+    return flexLex(value, m_flexScanner);
+}
+
+int Lexer::lineNo() const
+{
+    return (m_backend == FastBackend) ? m_fastLexer.lineNo() : flexLineNo(m_flexScanner);
+}
+
+int convertNumber(int token, const char* text, std::size_t length, YYSTYPE* value, int line)
+{
+    const char* end = text + length;
+    std::from_chars_result result;
+
+    switch (token) {
+    case TADDRESS:
+        // like strtoul(): "0x" alone is 0, a value too large is ULONG_MAX
+        if (length == 2) {
+            value->addressValue = 0;
+            return token;
+        }
+        result = std::from_chars(text + 2, end, value->addressValue, 16); // skip "0x"
+        if (result.ec == std::errc::result_out_of_range && result.ptr == end) {
+            value->addressValue = std::numeric_limits<unsigned long>::max();
+            return token;
+        }
+        if (result.ec != std::errc() || result.ptr != end) {
+            fprintf(stderr, "Invalid address at line %d\n", line);
+            return TINVALID;
+        }
+        return token;
+
+    case TINTEGER:
+        result = std::from_chars(text, end, value->integer);
+        if (result.ec == std::errc::result_out_of_range && result.ptr == end) {
+            // like atol()
+            value->integer = (text[0] == '-') ? std::numeric_limits<long long>::min()
+                                              : std::numeric_limits<long long>::max();
+            return token;
+        }
+        break;
+
+    case TDOUBLE:
+        result = std::from_chars(text, end, value->number);
+        if (result.ec == std::errc::result_out_of_range) {
+            // atof() gives infinity, a denormal or zero; strtod() needs a
+            // terminated copy, which is rare enough
+            value->number = strtod(std::string(text, length).c_str(), NULL);
+            return token;
+        }
+        result.ptr = end; // like atof, an exponent without digits is ignored
+        break;
+
+    default:
+        return TINVALID;
+    }
+
+    if (result.ec != std::errc() || result.ptr != end) {
+        fprintf(stderr, "Invalid number at line %d\n", line);
+        return TINVALID;
+    }
+
+    return token;
+}
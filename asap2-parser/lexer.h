@@ -0,0 +1,65 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "fastLexer.h"
+
+union YYSTYPE;
+
+// The parser can be fed by two interchangeable scanners: the flex scanner
+// from tokens.l and the hand-written FastLexer. Both return the same tokens.
+enum LexerBackend { FlexBackend, FastBackend };
+
+// The token source of one parse. Both scanners are reentrant, so every
+// thread can run its own Lexers.
+class Lexer
+{
+public:
+    explicit Lexer(LexerBackend backend);
+    ~Lexer();
+
+    // Sets the text the next lex() calls will read from; line is the line
+    // number of begin. String tokens refer into the text, so it has to
+    // outlive the parse.
+    void reset(const char* begin, const char* end, int line = 1);
+
+    // returns the next token id and fills value; 0 marks the end of input
+    int lex(YYSTYPE* value);
+
+    // current line, for error messages
+    int lineNo() const;
+
+    LexerBackend backend() const { return m_backend; }
+
+private:
+    // noncopyable, owns the flex scanner
+    Lexer(const Lexer&);
+    Lexer& operator=(const Lexer&);
+
+    LexerBackend m_backend;
+    FastLexer m_fastLexer;
+    void* m_flexScanner; // yyscan_t, NULL for the FastBackend
+};
+
+// Converts the text of a TINTEGER, TDOUBLE or TADDRESS token into the binary
+// semantic value, so the grammar actions never see numbers as strings.
+// Like the atol(), atof() and strtoul() calls it replaces, it saturates
+// values out of range. Returns token, or TINVALID, which is a syntax error,
+// if the text is not a valid number.
+int convertNumber(int token, const char* text, std::size_t length, YYSTYPE* value, int line);
@@ -0,0 +1,213 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <thread>
+#include <algorithm>
+
+#include <boost/unordered_set.hpp>
+
+#include "linker.h"
+#include "node.h"
+
+namespace {
+
+// names the A2L standard uses for "none", they are never defined
+bool isPlaceholder(Symbol name)
+{
+    const std::string& str = symbols().name(name);
+    return str == "NO_COMPU_METHOD" || str == "NO_INPUT_QUANTITY";
+}
+
+template<class T>
+const T* resolve(T* object, Symbol owner, const char* kind, Symbol name, DanglingList& dangling)
+{
+    if (object == NULL && !isPlaceholder(name)) {
+        DanglingReference reference = { owner, kind, name };
+        dangling.push_back(reference);
+    }
+    return object;
+}
+
+// writes the links of an axis; a shared one (see DescriptorPool) is resolved
+// once for all the characteristics it belongs to
+void resolveAxis(const NModule& module, NAxis* axis)
+{
+    axis->dataTypeRef = module.findMeasurement(axis->dataType);
+    axis->compuMethodRef = module.findCompuMethod(axis->compuMethod);
+    if (axis->getAxisStyle() == Extern) {
+        NComAxis* comAxis = static_cast<NComAxis*>(axis);
+        comAxis->axisPtsRef = module.findAxisPts(comAxis->axisPts);
+    }
+}
+
+// reports the missing objects of a resolved axis, for each owner of it
+void checkAxis(const NAxis* axis, Symbol owner, DanglingList& dangling)
+{
+    if (axis == NULL) return;
+
+    resolve(axis->dataTypeRef, owner, "MEASUREMENT", axis->dataType, dangling);
+    resolve(axis->compuMethodRef, owner, "COMPU_METHOD", axis->compuMethod, dangling);
+    if (axis->getAxisStyle() == Extern) {
+        const NComAxis* comAxis = static_cast<const NComAxis*>(axis);
+        resolve(comAxis->axisPtsRef, owner, "AXIS_PTS", comAxis->axisPts, dangling);
+    }
+}
+
+// the axes of characteristic, NULL if it has fewer
+void getAxes(NCharacteristic& characteristic, NAxis* (&axes)[2])
+{
+    axes[0] = axes[1] = NULL;
+
+    if (characteristic.kind == MapKind) {
+        NBaseMap& map = static_cast<NBaseMap&>(characteristic);
+        axes[0] = map.axisX();
+        axes[1] = map.axisY();
+    }
+    else if (characteristic.kind == CurveKind) {
+        axes[0] = static_cast<NCurve&>(characteristic).m_axis_1.get();
+    }
+}
+
+void linkFields(const NModule& module, NCharacteristic& characteristic, DanglingList& dangling)
+{
+    Symbol owner = characteristic.id;
+
+    characteristic.recordLayoutRef = resolve(module.findRecordLayout(characteristic.recordLayout),
+                                             owner, "RECORD_LAYOUT", characteristic.recordLayout, dangling);
+    characteristic.compuMethodRef = resolve(module.findCompuMethod(characteristic.compuMethod),
+                                            owner, "COMPU_METHOD", characteristic.compuMethod, dangling);
+}
+
+// the axes have been resolved by resolveAxes()
+void linkRange(const NModule& module, NCharacteristic* const* begin, NCharacteristic* const* end,
+               DanglingList* dangling)
+{
+    for (; begin != end; ++begin) {
+        NAxis* axes[2];
+        getAxes(**begin, axes);
+
+        linkFields(module, **begin, *dangling);
+        checkAxis(axes[0], (*begin)->id, *dangling);
+        checkAxis(axes[1], (*begin)->id, *dangling);
+        (*begin)->linked = true;
+    }
+}
+
+void resolveAxes(const NModule& module, NAxis* const* begin, NAxis* const* end)
+{
+    for (; begin != end; ++begin) {
+        resolveAxis(module, *begin);
+    }
+}
+
+// Calls f(begin, end, i) for threads contiguous ranges of items, the last
+// one on this thread, and waits for the others.
+template<class T, class F>
+void forEachRange(const std::vector<T>& items, unsigned threads, F f)
+{
+    SymbolTable& names = symbols(); // of the calling thread
+    std::vector<std::thread> workers;
+    std::size_t rangeSize = (items.size() + threads - 1) / threads;
+    for (unsigned i = 0; i < threads; ++i) {
+        const T* begin = items.data() + std::min(i * rangeSize, items.size());
+        const T* end = items.data() + std::min((i + 1) * rangeSize, items.size());
+
+        if (i + 1 == threads) {
+            f(begin, end, i);
+        }
+        else {
+            workers.push_back(std::thread([&names, f, begin, end, i]() {
+                SymbolScope scope(names);
+                f(begin, end, i);
+            }));
+        }
+    }
+
+    BOOST_FOREACH(std::thread& worker, workers) {
+        worker.join();
+    }
+}
+
+} // namespace
+
+void linkCharacteristic(const NModule& module, NCharacteristic& characteristic, DanglingList& dangling)
+{
+    NAxis* axes[2];
+    getAxes(characteristic, axes);
+
+    linkFields(module, characteristic, dangling);
+    for (int i = 0; i < 2 && axes[i] != NULL; ++i) {
+        resolveAxis(module, axes[i]);
+        checkAxis(axes[i], characteristic.id, dangling);
+    }
+    characteristic.linked = true;
+}
+
+std::size_t linkModule(const NModule& module, unsigned threads)
+{
+    const std::size_t MinPerThread = 1024; // below that a thread costs more than it saves
+
+    std::vector<NCharacteristic*> characteristics;
+    characteristics.reserve(module.characteristics.size());
+    BOOST_FOREACH(CharacteristicHashMap::value_type i, module.characteristics) {
+        characteristics.push_back(i.second);
+    }
+
+    // A shared axis (see DescriptorPool) may belong to maps of several
+    // ranges, so the distinct axes are resolved first, each by one worker.
+    // Then the characteristics are linked and report their missing objects.
+    std::vector<NAxis*> axes;
+    boost::unordered_set<const NAxis*> seen;
+    BOOST_FOREACH(NCharacteristic* characteristic, characteristics) {
+        NAxis* own[2];
+        getAxes(*characteristic, own);
+        for (int i = 0; i < 2 && own[i] != NULL; ++i) {
+            if (seen.insert(own[i]).second) axes.push_back(own[i]);
+        }
+    }
+
+    unsigned axisThreads = std::max<std::size_t>(1, std::min<std::size_t>(threads, axes.size() / MinPerThread));
+    forEachRange(axes, axisThreads, [&module](NAxis* const* begin, NAxis* const* end, unsigned) {
+        resolveAxes(module, begin, end);
+    });
+
+    // contiguous ranges, so the report keeps the order of the map
+    threads = std::max<std::size_t>(1, std::min<std::size_t>(threads, characteristics.size() / MinPerThread));
+    std::vector<DanglingList> dangling(threads);
+    forEachRange(characteristics, threads, [&module, &dangling](NCharacteristic* const* begin, NCharacteristic* const* end, unsigned i) {
+        linkRange(module, begin, end, &dangling[i]);
+    });
+
+    for (unsigned i = 1; i < threads; ++i) {
+        dangling[0].insert(dangling[0].end(), dangling[i].begin(), dangling[i].end());
+    }
+
+    reportDangling(dangling[0]);
+    return dangling[0].size();
+}
+
+void reportDangling(const DanglingList& dangling)
+{
+    if (dangling.empty()) return;
+
+    std::cerr << dangling.size() << " undefined references:\n";
+    BOOST_FOREACH(const DanglingReference& reference, dangling) {
+        std::cerr << "    " << symbols().name(reference.object) << ": " << reference.kind
+                  << ' ' << symbols().name(reference.name) << '\n';
+    }
+    std::cerr.flush();
+}
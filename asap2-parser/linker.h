@@ -0,0 +1,52 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "symbolTable.h"
+
+class NModule;
+class NCharacteristic;
+
+// A name an object refers to, but which is not defined in the module.
+struct DanglingReference
+{
+    Symbol object;      // the referring characteristic
+    const char* kind;   // the kind of the missing object, e.g. "COMPU_METHOD"
+    Symbol name;
+};
+
+typedef std::vector<DanglingReference> DanglingList;
+
+// The link stage resolves the names the characteristics refer to (record
+// layouts, compu methods, axis inputs and axis points) into the pointers
+// of the nodes once, so the generators follow pointers instead of looking
+// names up.
+
+// Links one characteristic and appends its dangling references. Objects of
+// a lazily parsed module are loaded as needed, so this must not run
+// concurrently on such a module.
+void linkCharacteristic(const NModule& module, NCharacteristic& characteristic, DanglingList& dangling);
+
+// Links all characteristics of a completely parsed module with up to
+// threads threads. The dangling references are reported on stderr in one
+// batch; returns their number.
+std::size_t linkModule(const NModule& module, unsigned threads = 1);
+
+void reportDangling(const DanglingList& dangling);
@@ -16,57 +16,491 @@
 
 #include <iostream>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <dirent.h>
 
 #include <boost/foreach.hpp>
 
-#include "stack.hpp"
+#include "arena.h"
 #include "node.h"
+#include "inputBuffer.h"
+#include "lexer.h"
+#include "parse.h"
+#include "modelCache.h"
+#include "incrementalParser.h"
+#include "threadPool.h"
+#include "modelServer.h"
+#include "characteristicColumns.h"
 #include "xdfGen.h"
+#include "outputSink.h"
+#include "fragmentCache.h"
 
 using namespace std;
 
-extern int yyparse();
-extern NProject* projectBlock;
-extern std::vector<std::string*> value_tokens;
-extern ext::stack<Node*> nodes;
+// --list: prints the objects while the file is streamed, none is kept
+class ListHandler : public StatementHandler, public Visitor
+{
+public:
+    bool statement(NStatement& statement)
+    {
+        statement.accept(*this);
+        return false;
+    }
+
+    void visit(NBaseMap* elem)              { print("MAP", elem); }
+    void visit(NCurve* elem)                { print("CURVE", elem); }
+    void visit(NValue* elem)                { print("VALUE", elem); }
+    void visit(NValBlk* elem)               { print("VAL_BLK", elem); }
+    void visit(NCharacteristicText* elem)   { print("ASCII", elem); }
+
+    void visit(NAxisPts* elem)              { print("AXIS_PTS", elem); }
+    void visit(NMeasurement* elem)          { print("MEASUREMENT", elem); }
+    void visit(NFunction* elem)             { print("FUNCTION", elem); }
+    void visit(NCompuMethod* elem)          { print("COMPU_METHOD", elem); }
+    void visit(NRecordLayout* elem)         { print("RECORD_LAYOUT", elem); }
+
+    void visit(NConstant* elem) { }
+    void visit(NVariable* elem) { }
+
+private:
+    void print(const char* kind, const NStatement* elem)
+    {
+        std::cout << kind << ' ' << elem->name() << '\n';
+    }
+};
+
+static void usage(const char* name)
+{
+    std::cerr << "usage: " << name << " [--lexer=flex|fast] [--jobs=N] [--select=NAME,...] [--range=BEGIN-END]\n"
+              << "       [--cache] [--fragments=file] [--list] [--watch] [-o file.xdf] [file.a2l]\n"
+              << "       " << name << " --batch [--lexer=flex|fast] [--jobs=N] [-o dir] file.a2l|dir...\n"
+              << "       " << name << " --serve=socket [--lexer=flex|fast] [--cache-size=MB]\n"
+              << "without a file the A2L is read from stdin\n"
+              << "--jobs=N parses the MODULE and renders the tables with N threads\n"
+              << "--select=NAME,... converts only the given characteristics, the\n"
+              << "    other objects are parsed only if they are referenced\n"
+              << "--range=BEGIN-END converts only the characteristics at addresses in\n"
+              << "    [BEGIN, END)\n"
+              << "--cache reuses file.a2l.cache, or writes it after parsing\n"
+              << "--fragments=file copies the tables which did not change since the last\n"
+              << "    conversion from file, and stores the tables of this one in it\n"
+              << "--list only lists the objects of the MODULE, in constant memory\n"
+              << "--watch converts the file again whenever it changes, only the\n"
+              << "    edited objects are parsed again\n"
+              << "-o file.xdf writes the XDF to a file instead of stdout\n"
+              << "--batch converts every file, and every *.a2l file of a directory,\n"
+              << "    with N files at a time, into file.xdf next to it or into dir\n"
+              << "--serve=socket answers the requests of other tools on a Unix socket,\n"
+              << "    and keeps up to --cache-size=MB (default 256) of parsed files" << std::endl;
+}
+
+// which characteristics are converted
+struct Selection
+{
+    std::vector<std::string> names; // --select
+    bool byAddress;                 // --range
+    unsigned long begin, end;
+
+    Selection() : byAddress(false), begin(0), end(0) { }
+
+    bool empty() const { return names.empty() && !byAddress; }
+};
+
+static void convert(const NModule& module, const Selection& selection, std::ostream& out, unsigned jobs,
+                    FragmentCache* fragments)
+{
+    if (!selection.byAddress) {
+        generateXdf(module, selection.names, out, jobs, NULL, fragments);
+        return;
+    }
+
+    CharacteristicColumns columns(module);
+    CharacteristicColumns::RowList rows;
+    columns.selectAddresses(selection.begin, selection.end, AllKinds, rows);
+
+    std::vector<NCharacteristic*> characteristics;
+    characteristics.reserve(rows.size());
+    BOOST_FOREACH (CharacteristicColumns::Row row, rows) {
+        characteristics.push_back(columns.object(row));
+    }
+    generateXdf(module, characteristics, out, jobs, NULL, fragments);
+}
+
+// the XDF is written while it is generated, see OutputSink; the tables are
+// reused from fragmentsPath if it is given
+static bool writeOutput(const NModule& module, const Selection& selected, const char* outputPath, unsigned jobs,
+                        const char* fragmentsPath)
+{
+    OutputSink sink;
+    if (outputPath == NULL) {
+        sink.attach(STDOUT_FILENO);
+    }
+    else if (!sink.open(outputPath)) {
+        return false;
+    }
+
+    FragmentCache fragments;
+    if (fragmentsPath != NULL) fragments.load(fragmentsPath);
+
+    std::ostream out(&sink);
+    convert(module, selected, out, jobs, fragmentsPath != NULL ? &fragments : NULL);
+
+    if (!sink.close()) {
+        std::cerr << "Unable to write " << (outputPath != NULL ? outputPath : "the XDF") << std::endl;
+        return false;
+    }
+
+    if (fragmentsPath != NULL) {
+        std::cerr << "reused " << fragments.hits() << " tables, rendered "
+                  << fragments.inserted() << std::endl;
+        return fragments.save(fragmentsPath);
+    }
+    return true;
+}
+
+// st_mtim and size, to notice when the file is saved again
+static bool fileVersion(const char* path, struct timespec* modified, off_t* size)
+{
+    struct stat info;
+    if (stat(path, &info) != 0) return false;
+
+    *modified = info.st_mtim;
+    *size = info.st_size;
+    return true;
+}
+
+// --watch: runs until it is killed
+static int watch(const char* path, LexerBackend backend, unsigned jobs, const Selection& selected, const char* outputPath,
+                 const char* fragmentsPath)
+{
+    typedef std::chrono::steady_clock clock;
+
+    IncrementalParser parser(backend);
+
+    struct timespec modified = { 0, 0 };
+    off_t size = 0;
+    bool first = true;
+
+    for (;; std::this_thread::sleep_for(std::chrono::milliseconds(200))) {
+        struct timespec nowModified;
+        off_t nowSize;
+        if (!fileVersion(path, &nowModified, &nowSize)) continue;
+
+        if (!first && nowModified.tv_sec == modified.tv_sec
+                && nowModified.tv_nsec == modified.tv_nsec && nowSize == size) {
+            continue;
+        }
+
+        modified = nowModified;
+        size = nowSize;
+
+        InputBuffer input;
+        if (!input.mapFile(path)) continue;
+
+        clock::time_point start = clock::now();
+        NProject* project = first ? parser.parse(input) : parser.update(input);
+        double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        if (project == NULL) {
+            std::cerr << "Failed to parse " << path << ", waiting for the next change" << std::endl;
+            continue;
+        }
+
+        first = false;
+        std::cerr << "parsed " << parser.parsedBlocks() << " of " << parser.totalBlocks()
+                  << " objects in " << ms << " ms" << std::endl;
+
+        writeOutput(project->m_module.ref(), selected, outputPath, jobs, fragmentsPath);
+    }
+
+    return 0;
+}
+
+static bool hasSuffix(const std::string& str, const char* suffix)
+{
+    std::string::size_type length = strlen(suffix);
+    return str.size() >= length && str.compare(str.size() - length, length, suffix) == 0;
+}
+
+// the files of --batch, directories are replaced by their *.a2l files
+static void collectInputs(const char* path, std::vector<std::string>& files)
+{
+    struct stat info;
+    if (stat(path, &info) != 0 || !S_ISDIR(info.st_mode)) {
+        files.push_back(path); // errors are reported when it is opened
+        return;
+    }
+
+    DIR* dir = opendir(path);
+    if (dir == NULL) {
+        std::cerr << "Unable to open " << path << ": " << strerror(errno) << std::endl;
+        return;
+    }
+
+    std::vector<std::string> found;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (hasSuffix(name, ".a2l") || hasSuffix(name, ".A2L")) {
+            found.push_back(std::string(path) + "/" + name);
+        }
+    }
+    closedir(dir);
+
+    std::sort(found.begin(), found.end()); // readdir has no order
+    files.insert(files.end(), found.begin(), found.end());
+}
+
+// file.a2l becomes file.xdf, in outputDir if it is given
+static std::string batchOutputPath(const std::string& input, const char* outputDir)
+{
+    std::string::size_type slash = input.rfind('/');
+    std::string::size_type dot = input.rfind('.');
+    std::string stem = (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+        ? input.substr(0, dot) : input;
+
+    if (outputDir == NULL) {
+        return stem + ".xdf";
+    }
+
+    std::string name = (slash == std::string::npos) ? stem : stem.substr(slash + 1);
+    return std::string(outputDir) + "/" + name + ".xdf";
+}
+
+// --batch: every file is parsed into its own arena by one of the workers
+static int batch(const std::vector<std::string>& files, LexerBackend backend, unsigned jobs, const char* outputDir)
+{
+    std::mutex reportMutex;
+    std::atomic<unsigned> failed(0);
+    std::vector<std::string> noSelection;
+
+    ThreadPool pool(std::min<std::size_t>(jobs, std::max<std::size_t>(files.size(), 1)));
+    BOOST_FOREACH (const std::string& file, files) {
+        pool.submit([&, file]() {
+            std::string outputPath = batchOutputPath(file, outputDir);
+            bool ok = false;
+
+            // a file which fails must not stop the others
+            bool opened = false;
+            try {
+                InputBuffer input;
+                if (input.mapFile(file.c_str())) {
+                    Arena arena;
+                    NProject* project = parseProject(input, arena, backend);
+                    OutputSink sink;
+                    if (project != NULL && sink.open(outputPath.c_str())) {
+                        opened = true;
+                        std::ostream out(&sink);
+                        generateXdf(project->m_module.ref(), noSelection, out);
+                        ok = sink.close();
+                    }
+                }
+            }
+            catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(reportMutex);
+                std::cerr << file << ": " << e.what() << std::endl;
+            }
+
+            if (opened && !ok) {
+                unlink(outputPath.c_str()); // no partial XDF is left behind
+            }
+
+            std::lock_guard<std::mutex> lock(reportMutex);
+            if (ok) {
+                std::cerr << file << " -> " << outputPath << std::endl;
+            }
+            else {
+                std::cerr << "Failed to convert " << file << std::endl;
+                ++failed;
+            }
+        });
+    }
+    pool.wait();
+
+    if (failed != 0) {
+        std::cerr << failed << " of " << files.size() << " files failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
 
 int main(int argc, char* argv[])
 {
-    int result = yyparse();
-    BOOST_FOREACH (std::vector<std::string*>::value_type i, value_tokens) {
-        delete i;
+    const char* path = NULL;
+    LexerBackend backend = FlexBackend;
+    unsigned jobs = 1;
+    Selection selected;
+    bool useCache = false;
+    bool list = false;
+    bool watchFile = false;
+    const char* outputPath = NULL;
+    const char* fragmentsPath = NULL;
+    bool batchMode = false;
+    std::vector<std::string> batchFiles;
+    const char* socketPath = NULL;
+    std::size_t cacheSize = 256;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--lexer=flex") {
+            backend = FlexBackend;
+        }
+        else if (arg == "--lexer=fast") {
+            backend = FastBackend;
+        }
+        else if (arg.compare(0, 7, "--jobs=") == 0 && atoi(arg.c_str() + 7) > 0) {
+            jobs = atoi(arg.c_str() + 7);
+        }
+        else if (arg == "--list") {
+            list = true;
+        }
+        else if (arg == "--watch") {
+            watchFile = true;
+        }
+        else if (arg.compare(0, 8, "--serve=") == 0 && arg.size() > 8) {
+            socketPath = argv[i] + 8;
+        }
+        else if (arg.compare(0, 13, "--cache-size=") == 0 && atoi(arg.c_str() + 13) > 0) {
+            cacheSize = atoi(arg.c_str() + 13);
+        }
+        else if (arg == "--batch") {
+            batchMode = true;
+        }
+        else if (arg == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        }
+        else if (arg == "--cache") {
+            useCache = true;
+        }
+        else if (arg.compare(0, 12, "--fragments=") == 0 && arg.size() > 12) {
+            fragmentsPath = argv[i] + 12;
+        }
+        else if (arg.compare(0, 9, "--select=") == 0) {
+            std::string::size_type begin = 9, comma;
+            do {
+                comma = arg.find(',', begin);
+                selected.names.push_back(arg.substr(begin, comma - begin));
+                begin = comma + 1;
+            } while (comma != std::string::npos);
+        }
+        else if (arg.compare(0, 8, "--range=") == 0) {
+            // --range=BEGIN-END, the numbers may be hex
+            char* dash;
+            selected.begin = strtoul(arg.c_str() + 8, &dash, 0);
+            if (*dash != '-') {
+                usage(argv[0]);
+                return -1;
+            }
+            selected.end = strtoul(dash + 1, NULL, 0);
+            selected.byAddress = true;
+        }
+        else if (arg[0] != '-' && batchMode) {
+            collectInputs(argv[i], batchFiles);
+        }
+        else if (arg[0] != '-' && path == NULL) {
+            path = argv[i];
+        }
+        else {
+            usage(argv[0]);
+            return -1;
+        }
     }
 
-    // delete our remaining nodes
-    BOOST_FOREACH (ext::stack<Node*>::value_type i, nodes) {
-        if (!i->hasParent())
-            delete i;
+    if (socketPath != NULL) {
+        ModelServer server(backend, cacheSize * 1024 * 1024);
+        return server.serve(socketPath) ? 0 : 1;
     }
 
-    if (result) {
-        std::cerr << "Failed to parse input stream!" << std::endl;
-        return result;
+    if (batchMode) {
+        if (path != NULL) { // given before --batch
+            std::vector<std::string> first;
+            collectInputs(path, first);
+            batchFiles.insert(batchFiles.begin(), first.begin(), first.end());
+        }
+        if (batchFiles.empty() || watchFile || list || useCache || fragmentsPath != NULL || !selected.empty()) {
+            usage(argv[0]);
+            return -1;
+        }
+        return batch(batchFiles, backend, jobs, outputPath);
     }
 
-    std::cout << projectBlock << endl;
-    if (projectBlock == NULL) {
+    if (watchFile) {
+        if (path == NULL) {
+            usage(argv[0]);
+            return -1;
+        }
+        return watch(path, backend, jobs, selected, outputPath, fragmentsPath);
+    }
+
+    InputBuffer input;
+    bool loaded = (path != NULL) ? input.mapFile(path) : input.readStream(stdin);
+    if (!loaded) {
         return -1;
     }
 
-    //	getchar();
+    // every node, also those of a failed parse, is released with the arena
+    Arena arena;
+    if (list) {
+        ListHandler handler;
+        if (parseProjectStreaming(input, arena, backend, handler) == NULL) {
+            std::cerr << "Failed to parse input stream!" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
-    XdfGen generator(projectBlock->m_module.ref(), -0x800000);
+    NProject* projectBlock = NULL;
+    std::string cacheFile;
+    if (useCache) {
+        if (path == NULL) {
+            usage(argv[0]);
+            return -1;
+        }
 
-    const CharacteristicHashMap& characteristics = projectBlock->m_module->characteristics;
-    BOOST_FOREACH (CharacteristicHashMap::value_type i, characteristics) {
-        NStatement* current = i.second;
-        assert(current != NULL);
-        current->accept(generator);
+        cacheFile = cachePath(path);
+        projectBlock = loadCachedProject(cacheFile, input, arena);
     }
-    generator.epilogue();
 
-    delete projectBlock; // this will delete our whole tree
-    projectBlock = NULL;
+    if (projectBlock == NULL) {
+        // the cache has to be written from a complete parse
+        if (!selected.names.empty() && !useCache) {
+            projectBlock = parseProjectLazy(input, arena, backend);
+        }
+        else if (jobs > 1) {
+            projectBlock = parseProjectParallel(input, arena, backend, jobs);
+        }
+        else {
+            projectBlock = parseProject(input, arena, backend);
+        }
 
-    return 0;
+        if (projectBlock != NULL && useCache) {
+            writeCache(cacheFile, input, *projectBlock);
+        }
+    }
+
+    if (projectBlock == NULL) {
+        std::cerr << "Failed to parse input stream!" << std::endl;
+        return 1;
+    }
+
+    std::clog << projectBlock << endl;
+
+    //	getchar();
+
+    bool written = writeOutput(projectBlock->m_module.ref(), selected, outputPath, jobs, fragmentsPath);
+
+    arena.release(); // this will release our whole tree at once
+
+    return written ? 0 : 1;
 }
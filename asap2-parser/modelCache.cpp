@@ -0,0 +1,1160 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <boost/foreach.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/cstdint.hpp>
+
+#include "node.h"
+#include "descriptorPool.h"
+#include "util.h"
+#include "inputBuffer.h"
+#include "modelCache.h"
+
+using boost::uint8_t;
+using boost::int16_t;
+using boost::int32_t;
+using boost::uint32_t;
+using boost::uint64_t;
+
+namespace {
+
+// The file starts with a FileHeader, followed by the sections. Every record
+// is a plain struct, so the file is only usable by the build which wrote it;
+// Version has to change with any of them.
+const char Magic[8] = { 'A', '2', 'L', 'C', 'A', 'C', 'H', 'E' };
+const uint32_t Version = 1;
+
+const uint32_t NotFound = ~uint32_t(0);
+
+// a string inside the StringSection
+struct Str
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+// a range of the SymbolSection
+struct ListRef
+{
+    uint32_t offset;
+    uint32_t count;
+};
+
+struct FormatRecord
+{
+    int16_t length;
+    int16_t decimalPl;
+};
+
+struct AxisRecord
+{
+    double min;
+    double max;
+    Str dataType;
+    Str compuMethod;
+    Str axisPts;       // Extern only
+    int32_t length;
+    FormatRecord format; // Intern and Fixed only
+    uint8_t style;     // AxisStyle
+};
+
+enum CharacteristicType { MapType, CurveType, ValueType, ValBlkType, TextType };
+
+struct CharacteristicRecord
+{
+    uint64_t address;
+    double scale;
+    double min;
+    double max;
+    Str description;
+    Str recordLayout;
+    Str compuMethod;
+    uint32_t axes[2]; // into the AxisSection, one for a curve
+    int32_t number;   // of a VAL_BLK, the size of an ASCII
+    FormatRecord format;
+    uint8_t type;     // CharacteristicType
+};
+
+enum MeasurementType { PlainMeasurement, BitMeasurement, ValueMeasurement, ArrayMeasurement };
+
+struct MeasurementRecord
+{
+    uint64_t address;
+    uint64_t bitMask;
+    double min;
+    double max;
+    Str description;
+    Str valueType;
+    int32_t dataType;
+    int32_t int1;
+    int32_t int2;
+    int32_t arraySize;
+    FormatRecord format;
+    uint8_t type;     // MeasurementType
+};
+
+struct AxisPtsRecord
+{
+    uint64_t address;
+    double scale;
+    double min;
+    double max;
+    Str description;
+    Str unit;
+    Str ident;
+    Str type;
+    int32_t size;
+    FormatRecord format;
+};
+
+struct CompuMethodRecord
+{
+    double coeffs[6];
+    Str description;
+    Str unit;
+    FormatRecord format;
+};
+
+struct RecordLayoutRecord
+{
+    int32_t xAxis[3]; // NoAxisType, ValAxisType, flags
+    int32_t yAxis[3];
+    int32_t fncValues[2]; // type, flags
+    uint8_t members;  // HasXAxis | HasYAxis | HasFncValues
+};
+
+enum { HasXAxis = 1, HasYAxis = 2, HasFncValues = 4 };
+
+struct FunctionRecord
+{
+    Str description;
+    ListRef lists[6]; // DEF_CHARACTERISTIC ... SUB_FUNCTION
+};
+
+enum SectionId
+{
+    StringSection,
+    SymbolSection, // Str, the names of the records and the function lists
+    AxisSection,
+    CharacteristicSection, // the record sections are in ObjectKind order
+    MeasurementSection,
+    AxisPtsSection,
+    CompuMethodSection,
+    RecordLayoutSection,
+    FunctionSection,
+    SeedSection,   // uint32_t, of the perfect hashes
+    SlotSection,   // uint32_t, slot -> record
+    SectionCount
+};
+
+const int KindCount = FunctionObject + 1;
+
+struct Section
+{
+    uint64_t offset;
+    uint64_t count;
+};
+
+// a minimal perfect hash from the names of one kind to its records
+struct Index
+{
+    uint32_t names;   // first name in the SymbolSection, one per record
+    uint32_t seeds;   // first seed in the SeedSection
+    uint32_t buckets;
+    uint32_t slots;   // first slot in the SlotSection, one per record
+};
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t inputSize;
+    uint64_t contentHash;
+
+    Str headerName;
+    Str headerModel;
+    Str projectNo;
+
+    Section sections[SectionCount];
+    Index indexes[KindCount];
+};
+
+const std::size_t RecordSizes[SectionCount] = {
+    1,
+    sizeof(Str),
+    sizeof(AxisRecord),
+    sizeof(CharacteristicRecord),
+    sizeof(MeasurementRecord),
+    sizeof(AxisPtsRecord),
+    sizeof(CompuMethodRecord),
+    sizeof(RecordLayoutRecord),
+    sizeof(FunctionRecord),
+    sizeof(uint32_t),
+    sizeof(uint32_t)
+};
+
+uint32_t hashName(std::string_view name, uint32_t seed)
+{
+    uint64_t h = 0xcbf29ce484222325ULL ^ (uint64_t(seed) * 0x9e3779b97f4a7c15ULL);
+    BOOST_FOREACH(char c, name) {
+        h = (h ^ uint8_t(c)) * 0x100000001b3ULL;
+    }
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    return uint32_t(h ^ (h >> 33));
+}
+
+// Hash and displace: the names are spread over buckets by a first hash.
+// Beginning with the largest bucket, every bucket gets the first seed for
+// which the second hash maps all of its names to free slots.
+bool buildPerfectHash(const std::vector<std::string_view>& names, std::vector<uint32_t>& seeds, std::vector<uint32_t>& slots)
+{
+    const uint32_t MaxSeed = 1 << 20; // only reached for duplicate names
+
+    uint32_t count = names.size();
+    uint32_t buckets = count / 2 + 1;
+
+    std::vector<std::vector<uint32_t> > members(buckets);
+    for (uint32_t i = 0; i < count; ++i) {
+        members[hashName(names[i], 0) % buckets].push_back(i);
+    }
+
+    std::vector<uint32_t> order(buckets);
+    for (uint32_t i = 0; i < buckets; ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&members](uint32_t a, uint32_t b) {
+        return members[a].size() > members[b].size();
+    });
+
+    seeds.assign(buckets, 0);
+    slots.assign(count, NotFound);
+
+    std::vector<uint32_t> taken;
+    BOOST_FOREACH(uint32_t bucket, order) {
+        const std::vector<uint32_t>& keys = members[bucket];
+        if (keys.empty()) break;
+
+        uint32_t seed = 1;
+        for (;; ++seed) {
+            if (seed == MaxSeed) return false;
+
+            taken.clear();
+            BOOST_FOREACH(uint32_t key, keys) {
+                uint32_t slot = hashName(names[key], seed) % count;
+                if (slots[slot] != NotFound) break;
+                slots[slot] = key;
+                taken.push_back(slot);
+            }
+
+            if (taken.size() == keys.size()) break;
+
+            BOOST_FOREACH(uint32_t slot, taken) {
+                slots[slot] = NotFound;
+            }
+        }
+
+        seeds[bucket] = seed;
+    }
+
+    return true;
+}
+
+FormatRecord toRecord(const Format& format)
+{
+    FormatRecord record = { format.length, format.decimalPl };
+    return record;
+}
+
+// collects the records while it visits the objects of a module
+class CacheWriter : public Visitor
+{
+public:
+    CacheWriter()
+    {
+        m_strings.reserve(1024 * 1024);
+    }
+
+    void add(ObjectKind kind, NStatement* object)
+    {
+        m_names[kind].push_back(addString(object->name()));
+        object->accept(*this);
+    }
+
+    bool write(const std::string& path, const InputBuffer& input, const NHeader& header);
+
+    void visit(NBaseMap* elem)
+    {
+        CharacteristicRecord record = characteristic(*elem, MapType);
+        if (!addMapAxes<NStdAxis>(elem, record) && !addMapAxes<NComAxis>(elem, record)) {
+            addMapAxes<NFixAxis>(elem, record);
+        }
+        m_characteristics.push_back(record);
+    }
+
+    void visit(NCurve* elem)
+    {
+        CharacteristicRecord record = characteristic(*elem, CurveType);
+        record.axes[0] = addAxis(elem->m_axis_1.ref());
+        m_characteristics.push_back(record);
+    }
+
+    void visit(NValue* elem)
+    {
+        m_characteristics.push_back(characteristic(*elem, ValueType));
+    }
+
+    void visit(NValBlk* elem)
+    {
+        CharacteristicRecord record = characteristic(*elem, ValBlkType);
+        record.number = elem->m_number;
+        m_characteristics.push_back(record);
+    }
+
+    void visit(NCharacteristicText* elem)
+    {
+        CharacteristicRecord record = characteristic(*elem, TextType);
+        record.number = elem->m_size;
+        m_characteristics.push_back(record);
+    }
+
+    void visit(NAxisPts* elem)
+    {
+        AxisPtsRecord record = AxisPtsRecord();
+        record.address = elem->address;
+        record.scale = elem->scale;
+        record.min = elem->min;
+        record.max = elem->max;
+        record.description = addString(elem->description);
+        record.unit = addSymbol(elem->unit);
+        record.ident = addSymbol(elem->ident);
+        record.type = addSymbol(elem->type);
+        record.size = elem->size;
+        record.format = toRecord(elem->format);
+        m_axisPts.push_back(record);
+    }
+
+    void visit(NMeasurement* elem)
+    {
+        MeasurementRecord record = MeasurementRecord();
+        record.address = elem->address;
+        record.min = elem->min;
+        record.max = elem->max;
+        record.description = addString(elem->description);
+        record.dataType = elem->dataType;
+        record.int1 = elem->int1;
+        record.int2 = elem->int2;
+        record.format = toRecord(elem->format);
+        record.type = PlainMeasurement;
+
+        if (const NMeasurementBit* bit = dynamic_cast<const NMeasurementBit*>(elem)) {
+            record.type = BitMeasurement;
+            record.bitMask = bit->bitMask;
+        }
+        else if (const NMeasurementValue* value = dynamic_cast<const NMeasurementValue*>(elem)) {
+            record.type = ValueMeasurement;
+            record.valueType = addSymbol(value->type);
+
+            if (const NMeasurementArray* array = dynamic_cast<const NMeasurementArray*>(elem)) {
+                record.type = ArrayMeasurement;
+                record.arraySize = array->arraySize;
+            }
+        }
+
+        m_measurements.push_back(record);
+    }
+
+    void visit(NFunction* elem)
+    {
+        FunctionRecord record = FunctionRecord();
+        record.description = addString(elem->description);
+
+        const SymbolList* lists[6] = {
+            elem->def_characteristic, elem->ref_characteristic,
+            elem->in_measurement, elem->out_measurement,
+            elem->loc_measurement, elem->sub_function
+        };
+
+        for (int i = 0; i < 6; ++i) {
+            record.lists[i].offset = m_symbols.size();
+            record.lists[i].count = lists[i]->size();
+            BOOST_FOREACH(Symbol symbol, *lists[i]) {
+                m_symbols.push_back(addSymbol(symbol));
+            }
+        }
+
+        m_functions.push_back(record);
+    }
+
+    void visit(NCompuMethod* elem)
+    {
+        CompuMethodRecord record = CompuMethodRecord();
+        std::copy(elem->coeffs, elem->coeffs + 6, record.coeffs);
+        record.description = addString(elem->description);
+        record.unit = addString(elem->unit);
+        record.format = toRecord(elem->format);
+        m_compuMethods.push_back(record);
+    }
+
+    void visit(NRecordLayout* elem)
+    {
+        RecordLayoutRecord record = RecordLayoutRecord();
+        if (elem->hasXAxis()) {
+            const NRecordLayout::AxisLayout& axis = elem->getXAxis();
+            record.members |= HasXAxis;
+            record.xAxis[0] = axis.NoAxisType;
+            record.xAxis[1] = axis.ValAxisType;
+            record.xAxis[2] = axis.flags;
+        }
+        if (elem->hasYAxis()) {
+            const NRecordLayout::AxisLayout& axis = elem->getYAxis();
+            record.members |= HasYAxis;
+            record.yAxis[0] = axis.NoAxisType;
+            record.yAxis[1] = axis.ValAxisType;
+            record.yAxis[2] = axis.flags;
+        }
+        if (elem->hasFncValues()) {
+            const NRecordLayout::FncValues& values = elem->getFncValues();
+            record.members |= HasFncValues;
+            record.fncValues[0] = values.type;
+            record.fncValues[1] = values.flags;
+        }
+        m_recordLayouts.push_back(record);
+    }
+
+    // not part of a module
+    void visit(NConstant* elem) { }
+    void visit(NVariable* elem) { }
+
+private:
+    Str addString(const char* data, std::size_t length)
+    {
+        std::string key(data, length);
+        boost::unordered_map<std::string, Str>::const_iterator i = m_pool.find(key);
+        if (i != m_pool.end()) {
+            return i->second;
+        }
+
+        Str str = { uint32_t(m_strings.size()), uint32_t(length) };
+        m_strings.append(data, length);
+        m_pool[key] = str;
+        return str;
+    }
+
+    Str addString(const std::string& str) { return addString(str.data(), str.size()); }
+    Str addString(const StringRef& str) { return addString(str.data, str.length); }
+    Str addSymbol(Symbol symbol) { return addString(symbols().name(symbol)); }
+
+    CharacteristicRecord characteristic(const NCharacteristic& elem, CharacteristicType type)
+    {
+        CharacteristicRecord record = CharacteristicRecord();
+        record.address = elem.address;
+        record.scale = elem.scale;
+        record.min = elem.min;
+        record.max = elem.max;
+        record.description = addString(elem.description);
+        record.recordLayout = addSymbol(elem.recordLayout);
+        record.compuMethod = addSymbol(elem.compuMethod);
+        record.axes[0] = record.axes[1] = NotFound;
+        record.format = toRecord(elem.format);
+        record.type = type;
+        return record;
+    }
+
+    template<class T>
+    bool addMapAxes(NBaseMap* elem, CharacteristicRecord& record)
+    {
+        if (elem->axisStyle() != T::style) {
+            return false;
+        }
+        const NMap<T>* map = static_cast<const NMap<T>*>(elem);
+
+        record.axes[0] = addAxis(map->m_axis_1.ref());
+        record.axes[1] = addAxis(map->m_axis_2.ref());
+        return true;
+    }
+
+    uint32_t addAxis(const NAxis& axis)
+    {
+        AxisRecord record = AxisRecord();
+        record.min = axis.min;
+        record.max = axis.max;
+        record.dataType = addSymbol(axis.dataType);
+        record.compuMethod = addSymbol(axis.compuMethod);
+        record.length = axis.length;
+        record.style = axis.getAxisStyle();
+
+        switch (axis.getAxisStyle()) {
+        case Extern:
+            record.axisPts = addSymbol(static_cast<const NComAxis&>(axis).axisPts);
+            break;
+        case Intern:
+            record.format = toRecord(static_cast<const NStdAxis&>(axis).format);
+            break;
+        case Fixed:
+            record.format = toRecord(static_cast<const NFixAxis&>(axis).format);
+            break;
+        }
+
+        // equal axes share a record, like their nodes do (DescriptorPool)
+        std::string key(reinterpret_cast<const char*>(&record), sizeof(record));
+        std::pair<boost::unordered_map<std::string, uint32_t>::iterator, bool> shared
+            = m_axisRecords.insert(std::make_pair(key, uint32_t(m_axes.size())));
+        if (shared.second) {
+            m_axes.push_back(record);
+        }
+        return shared.first->second;
+    }
+
+    std::string m_strings;
+    boost::unordered_map<std::string, Str> m_pool;
+
+    std::vector<Str> m_names[KindCount]; // in the order of the records
+    std::vector<Str> m_symbols;
+    std::vector<AxisRecord> m_axes;
+    boost::unordered_map<std::string, uint32_t> m_axisRecords; // by the bytes of the record
+    std::vector<CharacteristicRecord> m_characteristics;
+    std::vector<MeasurementRecord> m_measurements;
+    std::vector<AxisPtsRecord> m_axisPts;
+    std::vector<CompuMethodRecord> m_compuMethods;
+    std::vector<RecordLayoutRecord> m_recordLayouts;
+    std::vector<FunctionRecord> m_functions;
+};
+
+struct SectionData
+{
+    const void* data;
+    std::size_t count;
+};
+
+template<class T>
+SectionData sectionData(const std::vector<T>& records)
+{
+    SectionData section = { records.empty() ? NULL : &records[0], records.size() };
+    return section;
+}
+
+bool CacheWriter::write(const std::string& path, const InputBuffer& input, const NHeader& projectHeader)
+{
+    FileHeader header = FileHeader();
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.headerSize = sizeof(FileHeader);
+    header.inputSize = input.size();
+    header.contentHash = contentHash(input.begin(), input.end());
+    header.headerName = addString(projectHeader.name);
+    header.headerModel = addString(projectHeader.model);
+    header.projectNo = addSymbol(projectHeader.m_project->symbol);
+
+    // the names of each kind are stored in front of the function lists
+    std::vector<Str> symbolSection;
+    std::vector<uint32_t> seedSection, slotSection;
+    for (int kind = 0; kind < KindCount; ++kind) {
+        std::vector<std::string_view> names;
+        BOOST_FOREACH(const Str& name, m_names[kind]) {
+            names.push_back(std::string_view(m_strings.data() + name.offset, name.length));
+        }
+
+        std::vector<uint32_t> seeds, slots;
+        if (!buildPerfectHash(names, seeds, slots)) {
+            std::cerr << "Unable to index the cache, duplicate names?" << std::endl;
+            return false;
+        }
+
+        Index& index = header.indexes[kind];
+        index.names = symbolSection.size();
+        index.seeds = seedSection.size();
+        index.buckets = seeds.size();
+        index.slots = slotSection.size();
+
+        symbolSection.insert(symbolSection.end(), m_names[kind].begin(), m_names[kind].end());
+        seedSection.insert(seedSection.end(), seeds.begin(), seeds.end());
+        slotSection.insert(slotSection.end(), slots.begin(), slots.end());
+    }
+
+    // the lists refer into m_symbols
+    uint32_t listBase = symbolSection.size();
+    BOOST_FOREACH(FunctionRecord& function, m_functions) {
+        for (int i = 0; i < 6; ++i) function.lists[i].offset += listBase;
+    }
+    symbolSection.insert(symbolSection.end(), m_symbols.begin(), m_symbols.end());
+
+    SectionData sections[SectionCount] = {
+        { m_strings.data(), m_strings.size() },
+        sectionData(symbolSection),
+        sectionData(m_axes),
+        sectionData(m_characteristics),
+        sectionData(m_measurements),
+        sectionData(m_axisPts),
+        sectionData(m_compuMethods),
+        sectionData(m_recordLayouts),
+        sectionData(m_functions),
+        sectionData(seedSection),
+        sectionData(slotSection)
+    };
+
+    uint64_t offset = sizeof(FileHeader);
+    for (int i = 0; i < SectionCount; ++i) {
+        offset = (offset + 7) & ~uint64_t(7); // every section is 8-byte aligned
+        header.sections[i].offset = offset;
+        header.sections[i].count = sections[i].count;
+        offset += sections[i].count * RecordSizes[i];
+    }
+
+    // written under a temporary name, readers never see a partial file
+    std::string temporary = path + ".tmp" + std::to_string(getpid());
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == NULL) {
+        std::cerr << "Unable to create " << temporary << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+    for (int i = 0; ok && i < SectionCount; ++i) {
+        static const char padding[8] = { 0 };
+        std::size_t position = ftell(file);
+        ok = (fwrite(padding, 1, header.sections[i].offset - position, file) == header.sections[i].offset - position);
+
+        std::size_t size = sections[i].count * RecordSizes[i];
+        if (ok && size != 0) {
+            ok = (fwrite(sections[i].data, size, 1, file) == 1);
+        }
+    }
+
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+        std::cerr << "Unable to write " << path << ": " << strerror(errno) << std::endl;
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// A read-only mapping of a cache file. It creates the nodes of the objects
+// from their records when the module looks them up.
+class CacheLoader : public ObjectLoader
+{
+public:
+    CacheLoader() :
+        m_data(NULL),
+        m_size(0),
+        m_module(NULL),
+        m_arena(NULL),
+        m_descriptors(NULL)
+    { }
+
+    ~CacheLoader()
+    {
+        if (m_data != NULL) {
+            munmap(const_cast<char*>(m_data), m_size);
+        }
+    }
+
+    // false if path is no valid cache of input
+    bool open(const std::string& path, const InputBuffer& input);
+
+    NProject* createProject(Arena& arena);
+
+    bool load(ObjectKind kind, Symbol id)
+    {
+        uint32_t record = find(kind, symbols().name(id));
+        return (record != NotFound) && loadRecord(kind, record);
+    }
+
+    bool loadAll(ObjectKind kind)
+    {
+        for (uint32_t record = 0; record < m_loaded[kind].size(); ++record) {
+            loadRecord(kind, record);
+        }
+        return true;
+    }
+
+private:
+    template<class T>
+    const T* section(SectionId id) const
+    {
+        return reinterpret_cast<const T*>(m_data + header().sections[id].offset);
+    }
+
+    const FileHeader& header() const { return *reinterpret_cast<const FileHeader*>(m_data); }
+
+    StringRef string(const Str& str) const
+    {
+        return makeStringRef(section<char>(StringSection) + str.offset, str.length);
+    }
+
+    Symbol symbol(const Str& str) const
+    {
+        return symbols().intern(section<char>(StringSection) + str.offset, str.length);
+    }
+
+    bool validString(const Str& str) const
+    {
+        uint64_t size = header().sections[StringSection].count;
+        return str.offset <= size && str.length <= size - str.offset;
+    }
+
+    bool validRecords() const;
+
+    uint32_t find(ObjectKind kind, std::string_view name) const;
+    bool loadRecord(ObjectKind kind, uint32_t record);
+
+    NStatement* createCharacteristic(Symbol id, const CharacteristicRecord& record);
+    NStatement* createMeasurement(Symbol id, const MeasurementRecord& record);
+    NStatement* createAxisPts(Symbol id, const AxisPtsRecord& record);
+    NStatement* createCompuMethod(Symbol id, const CompuMethodRecord& record);
+    NStatement* createRecordLayout(Symbol id, const RecordLayoutRecord& record);
+    NStatement* createFunction(Symbol id, const FunctionRecord& record);
+    NAxis* createAxis(uint32_t index);
+
+    const char* m_data;
+    std::size_t m_size;
+    NModule* m_module;
+    Arena* m_arena;
+    DescriptorPool* m_descriptors; // in m_arena
+    std::vector<bool> m_loaded[KindCount];
+};
+
+bool CacheLoader::open(const std::string& path, const InputBuffer& input)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false; // there is no cache yet
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || std::size_t(info.st_size) < sizeof(FileHeader)) {
+        close(fd);
+        return false;
+    }
+
+    // shared, so every process reading this cache uses the same pages
+    void* p = mmap(0, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (p == MAP_FAILED) {
+        std::cerr << "Unable to map " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    m_data = static_cast<const char*>(p);
+    m_size = info.st_size;
+
+    const FileHeader& h = header();
+    if (memcmp(h.magic, Magic, sizeof(Magic)) != 0 || h.version != Version
+            || h.headerSize != sizeof(FileHeader) || h.inputSize != input.size()) {
+        return false;
+    }
+
+    for (int i = 0; i < SectionCount; ++i) {
+        const Section& section = h.sections[i];
+        if (section.offset > m_size || section.count > (m_size - section.offset) / RecordSizes[i]) {
+            std::cerr << "Ignoring the damaged cache " << path << std::endl;
+            return false;
+        }
+    }
+
+    // find() reaches into these sections through the indexes
+    for (int kind = 0; kind < KindCount; ++kind) {
+        const Index& index = h.indexes[kind];
+        uint64_t count = h.sections[CharacteristicSection + kind].count;
+        if (count == 0) continue;
+
+        if (index.buckets == 0 || uint64_t(index.seeds) + index.buckets > h.sections[SeedSection].count
+                || uint64_t(index.slots) + count > h.sections[SlotSection].count
+                || uint64_t(index.names) + count > h.sections[SymbolSection].count) {
+            std::cerr << "Ignoring the damaged cache " << path << std::endl;
+            return false;
+        }
+    }
+
+    if (h.contentHash != contentHash(input.begin(), input.end())) {
+        return false; // the input changed
+    }
+
+    if (!validRecords()) {
+        std::cerr << "Ignoring the damaged cache " << path << std::endl;
+        return false;
+    }
+
+    for (int kind = 0; kind < KindCount; ++kind) {
+        m_loaded[kind].assign(h.sections[CharacteristicSection + kind].count, false);
+    }
+
+    return true;
+}
+
+// The nodes are created from the records without further checks, so every
+// string, list, axis index and type tag has to point inside the file.
+bool CacheLoader::validRecords() const
+{
+    const FileHeader& h = header();
+    if (!validString(h.headerName) || !validString(h.headerModel) || !validString(h.projectNo)) {
+        return false;
+    }
+
+    const Str* names = section<Str>(SymbolSection);
+    uint64_t nameCount = h.sections[SymbolSection].count;
+    for (uint64_t i = 0; i < nameCount; ++i) {
+        if (!validString(names[i])) return false;
+    }
+
+    const AxisRecord* axes = section<AxisRecord>(AxisSection);
+    uint64_t axisCount = h.sections[AxisSection].count;
+    for (uint64_t i = 0; i < axisCount; ++i) {
+        const AxisRecord& r = axes[i];
+        if (r.style > Fixed || !validString(r.dataType) || !validString(r.compuMethod) || !validString(r.axisPts)) {
+            return false;
+        }
+    }
+
+    const CharacteristicRecord* characteristics = section<CharacteristicRecord>(CharacteristicSection);
+    for (uint64_t i = 0; i < h.sections[CharacteristicSection].count; ++i) {
+        const CharacteristicRecord& r = characteristics[i];
+        if (r.type > TextType || !validString(r.description) || !validString(r.recordLayout)
+                || !validString(r.compuMethod)) {
+            return false;
+        }
+
+        int axisRefs = (r.type == MapType) ? 2 : (r.type == CurveType) ? 1 : 0;
+        for (int j = 0; j < axisRefs; ++j) {
+            if (r.axes[j] >= axisCount) return false;
+        }
+    }
+
+    const MeasurementRecord* measurements = section<MeasurementRecord>(MeasurementSection);
+    for (uint64_t i = 0; i < h.sections[MeasurementSection].count; ++i) {
+        const MeasurementRecord& r = measurements[i];
+        if (r.type > ArrayMeasurement || !validString(r.description) || !validString(r.valueType)) {
+            return false;
+        }
+    }
+
+    const AxisPtsRecord* axisPts = section<AxisPtsRecord>(AxisPtsSection);
+    for (uint64_t i = 0; i < h.sections[AxisPtsSection].count; ++i) {
+        const AxisPtsRecord& r = axisPts[i];
+        if (!validString(r.description) || !validString(r.unit) || !validString(r.ident) || !validString(r.type)) {
+            return false;
+        }
+    }
+
+    const CompuMethodRecord* compuMethods = section<CompuMethodRecord>(CompuMethodSection);
+    for (uint64_t i = 0; i < h.sections[CompuMethodSection].count; ++i) {
+        if (!validString(compuMethods[i].description) || !validString(compuMethods[i].unit)) {
+            return false;
+        }
+    }
+
+    const FunctionRecord* functions = section<FunctionRecord>(FunctionSection);
+    for (uint64_t i = 0; i < h.sections[FunctionSection].count; ++i) {
+        const FunctionRecord& r = functions[i];
+        if (!validString(r.description)) return false;
+
+        for (int j = 0; j < 6; ++j) {
+            if (r.lists[j].offset > nameCount || r.lists[j].count > nameCount - r.lists[j].offset) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+NProject* CacheLoader::createProject(Arena& arena)
+{
+    const FileHeader& h = header();
+    NHeader* projectHeader = new (arena) NHeader(string(h.headerName), string(h.headerModel),
+                                                 new (arena) NIdentifier(symbol(h.projectNo)));
+
+    m_arena = &arena;
+    m_descriptors = arena.create<DescriptorPool>(arena);
+    arena.addFinalizer(m_descriptors);
+    m_module = new (arena) NModule(new (arena) NBlock(arena));
+    arena.addFinalizer(m_module); // the maps are not arena allocated
+
+    return new (arena) NProject(projectHeader, m_module);
+}
+
+uint32_t CacheLoader::find(ObjectKind kind, std::string_view name) const
+{
+    const Index& index = header().indexes[kind];
+    uint32_t count = m_loaded[kind].size();
+    if (count == 0) {
+        return NotFound;
+    }
+
+    uint32_t seed = section<uint32_t>(SeedSection)[index.seeds + hashName(name, 0) % index.buckets];
+    uint32_t record = section<uint32_t>(SlotSection)[index.slots + hashName(name, seed) % count];
+    if (record >= count) {
+        return NotFound; // a damaged slot
+    }
+
+    // every name hits some slot, so check that it is the right one
+    StringRef found = string(section<Str>(SymbolSection)[index.names + record]);
+    if (std::string_view(found.data, found.length) != name) {
+        return NotFound;
+    }
+
+    return record;
+}
+
+bool CacheLoader::loadRecord(ObjectKind kind, uint32_t record)
+{
+    if (m_loaded[kind][record]) {
+        return false;
+    }
+    m_loaded[kind][record] = true;
+
+    Symbol id = symbol(section<Str>(SymbolSection)[header().indexes[kind].names + record]);
+    NStatement* statement = NULL;
+
+    switch (kind) {
+    case CharacteristicObject:
+        statement = createCharacteristic(id, section<CharacteristicRecord>(CharacteristicSection)[record]);
+        break;
+    case MeasurementObject:
+        statement = createMeasurement(id, section<MeasurementRecord>(MeasurementSection)[record]);
+        break;
+    case AxisPtsObject:
+        statement = createAxisPts(id, section<AxisPtsRecord>(AxisPtsSection)[record]);
+        break;
+    case CompuMethodObject:
+        statement = createCompuMethod(id, section<CompuMethodRecord>(CompuMethodSection)[record]);
+        break;
+    case RecordLayoutObject:
+        statement = createRecordLayout(id, section<RecordLayoutRecord>(RecordLayoutSection)[record]);
+        break;
+    case FunctionObject:
+        statement = createFunction(id, section<FunctionRecord>(FunctionSection)[record]);
+        break;
+    }
+
+    if (statement == NULL) {
+        return false;
+    }
+
+    m_module->addStatement(statement);
+    return true;
+}
+
+Format toFormat(const FormatRecord& record)
+{
+    Format format = { record.length, record.decimalPl };
+    return format;
+}
+
+NAxis* CacheLoader::createAxis(uint32_t index)
+{
+    if (index >= header().sections[AxisSection].count) {
+        return NULL;
+    }
+
+    const AxisRecord& record = section<AxisRecord>(AxisSection)[index];
+    Symbol dataType = symbol(record.dataType);
+    Symbol compuMethod = symbol(record.compuMethod);
+
+    switch (record.style) {
+    case Extern:
+        return m_descriptors->comAxis(dataType, compuMethod, record.length, record.min, record.max, symbol(record.axisPts));
+    case Intern:
+        return m_descriptors->stdAxis(dataType, compuMethod, record.length, record.min, record.max, toFormat(record.format));
+    case Fixed:
+        return m_descriptors->fixAxis(dataType, compuMethod, record.length, record.min, record.max, toFormat(record.format));
+    }
+
+    return NULL;
+}
+
+NStatement* CacheLoader::createCharacteristic(Symbol id, const CharacteristicRecord& record)
+{
+    Arena& arena = *m_arena;
+    StringRef description = string(record.description);
+    Symbol recordLayout = symbol(record.recordLayout);
+    Symbol compuMethod = symbol(record.compuMethod);
+    Format format = toFormat(record.format);
+
+    switch (record.type) {
+    case MapType:
+        return createMap(arena, id, description, record.address, recordLayout, record.scale,
+                         compuMethod, record.min, record.max, format,
+                         createAxis(record.axes[0]), createAxis(record.axes[1]));
+    case CurveType:
+        return new (arena) NCurve(id, description, record.address, recordLayout, record.scale,
+                                  compuMethod, record.min, record.max, format, createAxis(record.axes[0]));
+    case ValueType:
+        return new (arena) NValue(id, description, record.address, recordLayout, record.scale,
+                                  compuMethod, record.min, record.max, format);
+    case ValBlkType:
+        return new (arena) NValBlk(id, description, record.address, recordLayout, record.scale,
+                                   compuMethod, record.min, record.max, format, record.number);
+    case TextType:
+        return new (arena) NCharacteristicText(id, description, record.address, recordLayout, record.scale,
+                                               compuMethod, record.min, record.max, format, record.number);
+    }
+
+    return NULL;
+}
+
+NStatement* CacheLoader::createMeasurement(Symbol id, const MeasurementRecord& record)
+{
+    Arena& arena = *m_arena;
+    StringRef description = string(record.description);
+    Format format = toFormat(record.format);
+
+    switch (record.type) {
+    case PlainMeasurement:
+        return new (arena) NMeasurement(id, description, record.dataType, record.int1, record.int2,
+                                        record.min, record.max, format, record.address);
+    case BitMeasurement:
+        return new (arena) NMeasurementBit(id, description, record.dataType, record.int1, record.int2,
+                                           record.min, record.max, format, record.address, record.bitMask);
+    case ValueMeasurement:
+        return new (arena) NMeasurementValue(id, description, record.dataType, record.int1, record.int2,
+                                             record.min, record.max, format, record.address, symbol(record.valueType));
+    case ArrayMeasurement:
+        return new (arena) NMeasurementArray(id, description, record.dataType, record.int1, record.int2,
+                                             record.min, record.max, format, record.address, symbol(record.valueType),
+                                             record.arraySize);
+    }
+
+    return NULL;
+}
+
+NStatement* CacheLoader::createAxisPts(Symbol id, const AxisPtsRecord& record)
+{
+    return new (*m_arena) NAxisPts(id, string(record.description), record.address,
+                                   symbol(record.unit), symbol(record.ident), record.scale,
+                                   symbol(record.type), record.size, record.min, record.max,
+                                   toFormat(record.format));
+}
+
+NStatement* CacheLoader::createCompuMethod(Symbol id, const CompuMethodRecord& record)
+{
+    return new (*m_arena) NCompuMethod(id, string(record.description), toFormat(record.format),
+                                       string(record.unit), record.coeffs);
+}
+
+NStatement* CacheLoader::createRecordLayout(Symbol id, const RecordLayoutRecord& record)
+{
+    Arena& arena = *m_arena;
+    NRecordLayout::FncValues* fncValues = NULL;
+    if (record.members & HasFncValues) {
+        fncValues = m_descriptors->fncValues(record.fncValues[0], record.fncValues[1]);
+    }
+
+    const int32_t* x = record.xAxis;
+    const int32_t* y = record.yAxis;
+    if (record.members & HasYAxis) {
+        return NRecordLayout::createRecordLayout(arena, id, x[0], x[1], x[2], y[0], y[1], y[2], fncValues, m_descriptors);
+    }
+    if (record.members & HasXAxis) {
+        return NRecordLayout::createRecordLayout(arena, id, x[0], x[1], x[2], fncValues, m_descriptors);
+    }
+    return NRecordLayout::createRecordLayout(arena, id, fncValues);
+}
+
+NStatement* CacheLoader::createFunction(Symbol id, const FunctionRecord& record)
+{
+    Arena& arena = *m_arena;
+    const Str* names = section<Str>(SymbolSection);
+
+    SymbolList* lists[6]; // open() checked the ranges
+    for (int i = 0; i < 6; ++i) {
+        const ListRef& ref = record.lists[i];
+        lists[i] = arena.create<SymbolList>(arena);
+        lists[i]->reserve(ref.count);
+        for (uint32_t j = 0; j < ref.count; ++j) {
+            lists[i]->push_back(symbol(names[ref.offset + j]));
+        }
+    }
+
+    return new (arena) NFunction(id, string(record.description),
+                                 lists[0], lists[1], lists[2], lists[3], lists[4], lists[5]);
+}
+
+} // namespace
+
+std::string cachePath(const char* inputPath)
+{
+    return std::string(inputPath) + ".cache";
+}
+
+NProject* loadCachedProject(const std::string& path, const InputBuffer& input, Arena& arena)
+{
+    CacheLoader* loader = arena.create<CacheLoader>();
+    arena.addFinalizer(loader);
+
+    if (!loader->open(path, input)) {
+        return NULL;
+    }
+
+    NProject* project = loader->createProject(arena);
+
+    // the generators walk all functions to find the categories
+    loader->loadAll(FunctionObject);
+
+    project->m_module->setLoader(loader);
+    return project;
+}
+
+bool writeCache(const std::string& path, const InputBuffer& input, const NProject& project)
+{
+    const NModule& module = project.m_module.ref();
+    module.loadAll(CharacteristicObject);
+    module.loadAll(MeasurementObject);
+    module.loadAll(AxisPtsObject);
+    module.loadAll(CompuMethodObject);
+    module.loadAll(RecordLayoutObject);
+    module.loadAll(FunctionObject);
+
+    CacheWriter writer;
+    BOOST_FOREACH(const CharacteristicHashMap::value_type& i, module.characteristics) {
+        writer.add(CharacteristicObject, i.second);
+    }
+    BOOST_FOREACH(const MeasurementHashMap::value_type& i, module.measurements) {
+        writer.add(MeasurementObject, i.second);
+    }
+    BOOST_FOREACH(const AxisPtsHashMap::value_type& i, module.axisPts) {
+        writer.add(AxisPtsObject, i.second);
+    }
+    BOOST_FOREACH(const CompuMethodHashMap::value_type& i, module.compuMethods) {
+        writer.add(CompuMethodObject, i.second);
+    }
+    BOOST_FOREACH(const RecordLayoutHashMap::value_type& i, module.recordLayouts) {
+        writer.add(RecordLayoutObject, i.second);
+    }
+    BOOST_FOREACH(const FunctionHashMap::value_type& i, module.functions) {
+        writer.add(FunctionObject, i.second);
+    }
+
+    return writer.write(path, input, project.m_header.ref());
+}
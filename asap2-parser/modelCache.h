@@ -0,0 +1,43 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+
+class Arena;
+class InputBuffer;
+class NProject;
+
+// A parsed module can be stored in a binary cache file next to its input.
+// The file is memory-mapped read-only and used in place: names are found
+// through a perfect hash, and a node is created from its record only when
+// NModule looks the object up. All processes which read the same cache
+// share the pages of the mapping.
+//
+// A cache is valid as long as the content hash of the input matches.
+
+// the cache file of an A2L file: "file.a2l.cache"
+std::string cachePath(const char* inputPath);
+
+// Returns NULL if there is no valid cache for input. Like parseProjectLazy(),
+// only the functions are loaded right away. The mapping is released with
+// arena.
+NProject* loadCachedProject(const std::string& path, const InputBuffer& input, Arena& arena);
+
+// Stores the module of project, which has to be parsed from input
+// completely. The file is replaced atomically. Returns false on errors.
+bool writeCache(const std::string& path, const InputBuffer& input, const NProject& project);
@@ -0,0 +1,464 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "modelServer.h"
+#include "arena.h"
+#include "inputBuffer.h"
+#include "parse.h"
+#include "node.h"
+#include "util.h"
+#include "xdfGen.h"
+#include "characteristicColumns.h"
+#include "crossReference.h"
+
+struct ModelServer::Model
+{
+    SymbolTable names; // of the nodes, released after them
+    std::string path;
+    struct timespec modified;
+    off_t size;
+    boost::uint64_t hash;
+    std::size_t bytes; // everything the model holds, see acquire()
+
+    Arena arena;
+    NProject* project;
+    std::unique_ptr<CharacteristicColumns> columns; // for RANGE and USING
+    std::unique_ptr<CrossReference> references;     // for REFS and the XDF
+};
+
+namespace {
+
+// the A2L keyword of an object, for QUERY
+class KindVisitor : public Visitor
+{
+public:
+    const char* kind;
+
+    KindVisitor() : kind("") { }
+
+    void visit(NBaseMap* elem)              { kind = "MAP"; }
+    void visit(NCurve* elem)                { kind = "CURVE"; }
+    void visit(NValue* elem)                { kind = "VALUE"; }
+    void visit(NValBlk* elem)               { kind = "VAL_BLK"; }
+    void visit(NCharacteristicText* elem)   { kind = "ASCII"; }
+
+    void visit(NAxisPts* elem)              { kind = "AXIS_PTS"; }
+    void visit(NMeasurement* elem)          { kind = "MEASUREMENT"; }
+    void visit(NFunction* elem)             { kind = "FUNCTION"; }
+    void visit(NCompuMethod* elem)          { kind = "COMPU_METHOD"; }
+    void visit(NRecordLayout* elem)         { kind = "RECORD_LAYOUT"; }
+
+    void visit(NConstant* elem) { }
+    void visit(NVariable* elem) { }
+};
+
+template<class Map>
+NStatement* findObject(const Map& map, Symbol id)
+{
+    typename Map::const_iterator it = map.find(id);
+    return (it != map.end()) ? it->second : NULL;
+}
+
+bool ok(const std::string& payload, std::string& answer)
+{
+    std::ostringstream header;
+    header << "OK " << payload.size() << '\n';
+    answer = header.str() + payload;
+    return true;
+}
+
+bool error(const std::string& message, std::string& answer)
+{
+    answer = "ERR " + message + '\n';
+    return false;
+}
+
+// "KIND NAME" of every row
+std::string listRows(const CharacteristicColumns& columns, const CharacteristicColumns::RowList& rows)
+{
+    static const char* const kindNames[] = { "MAP", "CURVE", "VALUE", "VAL_BLK", "ASCII" };
+
+    std::string list;
+    BOOST_FOREACH(CharacteristicColumns::Row row, rows) {
+        list += kindNames[columns.kind(row)];
+        list += ' ';
+        list += columns.object(row)->name();
+        list += '\n';
+    }
+    return list;
+}
+
+// "ROLE FUNCTION" of every reference
+void listReferences(const CrossReference::Range& range, std::string& list)
+{
+    for (const CrossReference::Reference* i = range.first; i != range.second; ++i) {
+        list += CrossReference::roleName(i->role);
+        list += ' ';
+        list += symbols().name(i->function);
+        list += '\n';
+    }
+}
+
+bool sendAll(int fd, const char* data, std::size_t size)
+{
+    while (size > 0) {
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL); // no SIGPIPE if the client is gone
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+} // namespace
+
+ModelServer::ModelServer(LexerBackend backend, std::size_t cacheSize) :
+    m_backend(backend),
+    m_cacheSize(cacheSize),
+    m_cachedBytes(0),
+    m_hits(0),
+    m_misses(0)
+{ }
+
+ModelServer::ModelPtr ModelServer::acquire(const std::string& path, std::string& error)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        error = "unable to stat " + path + ": " + strerror(errno);
+        return ModelPtr();
+    }
+
+    ModelPtr cached;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ModelIndex::iterator it = m_index.find(path);
+        if (it != m_index.end()) {
+            cached = *it->second;
+            if (cached->modified.tv_sec == info.st_mtim.tv_sec && cached->modified.tv_nsec == info.st_mtim.tv_nsec
+                    && cached->size == info.st_size) {
+                m_models.splice(m_models.begin(), m_models, it->second);
+                ++m_hits;
+                return cached;
+            }
+        }
+    }
+
+    InputBuffer input;
+    if (!input.mapFile(path.c_str())) {
+        error = "unable to read " + path;
+        return ModelPtr();
+    }
+
+    boost::uint64_t hash = contentHash(input.begin(), input.end());
+    if (cached && cached->hash == hash && cached->size == static_cast<off_t>(input.size())) {
+        // touched, but not changed
+        std::lock_guard<std::mutex> lock(m_mutex);
+        cached->modified = info.st_mtim;
+        ModelIndex::iterator it = m_index.find(path);
+        if (it != m_index.end() && *it->second == cached) {
+            m_models.splice(m_models.begin(), m_models, it->second);
+        }
+        ++m_hits;
+        return cached;
+    }
+
+    // the nodes do not refer to the input, it is released after the parse
+    ModelPtr model(new Model());
+    model->path = path;
+    model->modified = info.st_mtim;
+    model->size = input.size();
+    model->hash = hash;
+
+    SymbolScope scope(model->names);
+    model->project = parseProject(input, model->arena, m_backend);
+    if (model->project == NULL) {
+        error = "failed to parse " + path;
+        return ModelPtr();
+    }
+    const NModule& module = model->project->m_module.ref();
+    model->columns.reset(new CharacteristicColumns(module));
+    model->references.reset(new CrossReference(module));
+
+    model->bytes = model->arena.capacity() + module.memoryUsage() + model->columns->memoryUsage()
+        + model->references->memoryUsage() + model->names.memoryUsage();
+
+    insert(model);
+    return model;
+}
+
+void ModelServer::insert(const ModelPtr& model)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_misses;
+
+    ModelIndex::iterator it = m_index.find(model->path);
+    if (it != m_index.end()) {
+        m_cachedBytes -= (*it->second)->bytes;
+        m_models.erase(it->second);
+        m_index.erase(it);
+    }
+
+    m_models.push_front(model);
+    m_index[model->path] = m_models.begin();
+    m_cachedBytes += model->bytes;
+
+    // clients which still use a dropped model keep it alive until they are done
+    while (m_cachedBytes > m_cacheSize && m_models.size() > 1) {
+        const ModelPtr& oldest = m_models.back();
+        m_cachedBytes -= oldest->bytes;
+        m_index.erase(oldest->path);
+        m_models.pop_back();
+    }
+}
+
+bool ModelServer::handle(const std::string& request, std::string& answer)
+{
+    std::string::size_type space = request.find(' ');
+    std::string command = request.substr(0, space);
+    std::string arguments = (space != std::string::npos) ? request.substr(space + 1) : std::string();
+
+    if (command == "STATS") {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ostringstream stats;
+        stats << "models " << m_models.size() << '\n'
+              << "bytes " << m_cachedBytes << '\n'
+              << "limit " << m_cacheSize << '\n'
+              << "hits " << m_hits << '\n'
+              << "misses " << m_misses << '\n';
+        return ok(stats.str(), answer);
+    }
+
+    // these have one word before the path
+    std::string name;
+    if (command == "SELECT" || command == "QUERY" || command == "RANGE" || command == "USING"
+            || command == "REFS") {
+        space = arguments.find(' ');
+        if (space == std::string::npos) {
+            return error("usage: " + command + " NAME path", answer);
+        }
+        name = arguments.substr(0, space);
+        arguments.erase(0, space + 1);
+    }
+    else if (command != "LOAD" && command != "XDF") {
+        return error("unknown request " + command, answer);
+    }
+
+    if (arguments.empty()) {
+        return error("no file given", answer);
+    }
+
+    // the clients run in detached threads, an exception would end the server
+    try {
+        return respond(command, name, arguments, answer);
+    }
+    catch (const std::exception& e) {
+        return error(arguments + ": " + e.what(), answer);
+    }
+}
+
+bool ModelServer::respond(const std::string& command, const std::string& name, const std::string& path,
+                          std::string& answer)
+{
+    std::string message;
+    ModelPtr model = acquire(path, message);
+    if (!model) {
+        return error(message, answer);
+    }
+
+    SymbolScope scope(model->names);
+
+    const NModule& module = model->project->m_module.ref();
+
+    if (command == "LOAD") {
+        std::ostringstream counts;
+        counts << "characteristics " << module.characteristics.size() << '\n'
+               << "axis_pts " << module.axisPts.size() << '\n'
+               << "measurements " << module.measurements.size() << '\n'
+               << "functions " << module.functions.size() << '\n'
+               << "compu_methods " << module.compuMethods.size() << '\n'
+               << "record_layouts " << module.recordLayouts.size() << '\n';
+        return ok(counts.str(), answer);
+    }
+
+    if (command == "RANGE") {
+        char* dash;
+        unsigned long begin = strtoul(name.c_str(), &dash, 0);
+        if (*dash != '-') {
+            return error("usage: RANGE BEGIN-END path", answer);
+        }
+        unsigned long end = strtoul(dash + 1, NULL, 0);
+
+        CharacteristicColumns::RowList rows;
+        model->columns->selectAddresses(begin, end, AllKinds, rows);
+        return ok(listRows(*model->columns, rows), answer);
+    }
+
+    if (command == "USING") {
+        CharacteristicColumns::RowList rows;
+        Symbol id;
+        if (symbols().find(name, &id)) {
+            model->columns->selectCompuMethod(id, AllKinds, rows);
+        }
+        return ok(listRows(*model->columns, rows), answer);
+    }
+
+    if (command == "QUERY") {
+        // a name which is not interned cannot be in any model
+        Symbol id;
+        NStatement* object = NULL;
+        if (symbols().find(name, &id)) {
+            if (!object) object = findObject(module.characteristics, id);
+            if (!object) object = findObject(module.axisPts, id);
+            if (!object) object = findObject(module.measurements, id);
+            if (!object) object = findObject(module.functions, id);
+            if (!object) object = findObject(module.compuMethods, id);
+            if (!object) object = findObject(module.recordLayouts, id);
+        }
+        if (object == NULL) {
+            return error("unknown object " + name, answer);
+        }
+
+        KindVisitor kind;
+        object->accept(kind);
+        return ok(std::string(kind.kind) + ' ' + name + '\n', answer);
+    }
+
+    if (command == "REFS") {
+        std::string list;
+        Symbol id;
+        if (symbols().find(name, &id)) {
+            const CrossReference& references = *model->references;
+            CrossReference::Range ranges[] = {
+                references.characteristic(id), references.measurement(id), references.subFunctions(id)
+            };
+            BOOST_FOREACH(const CrossReference::Range& range, ranges) {
+                listReferences(range, list);
+            }
+        }
+        return ok(list, answer);
+    }
+
+    std::vector<std::string> selected;
+    if (command == "SELECT") {
+        std::string::size_type begin = 0, comma;
+        do {
+            comma = name.find(',', begin);
+            selected.push_back(name.substr(begin, comma - begin));
+            begin = comma + 1;
+        } while (comma != std::string::npos);
+
+        for (std::size_t i = 0; i < selected.size(); ++i) {
+            Symbol id;
+            if (!symbols().find(selected[i], &id) || findObject(module.characteristics, id) == NULL) {
+                return error("unknown characteristic " + selected[i], answer);
+            }
+        }
+    }
+
+    std::ostringstream xdf;
+    generateXdf(module, selected, xdf, 1, model->references.get());
+    return ok(xdf.str(), answer);
+}
+
+void ModelServer::serveClient(int client)
+{
+    std::string pending;
+    char buffer[4096];
+
+    for (;;) {
+        ssize_t n = read(client, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        pending.append(buffer, n);
+
+        std::string::size_type newline;
+        while ((newline = pending.find('\n')) != std::string::npos) {
+            std::string request = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+
+            if (!request.empty() && request[request.size() - 1] == '\r') {
+                request.erase(request.size() - 1);
+            }
+            if (request.empty()) continue;
+
+            std::string answer;
+            handle(request, answer);
+            if (!sendAll(client, answer.data(), answer.size())) {
+                close(client);
+                return;
+            }
+        }
+    }
+
+    close(client);
+}
+
+bool ModelServer::serve(const char* socketPath)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath << std::endl;
+        return false;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0) {
+        std::cerr << "Unable to create a socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    unlink(socketPath); // left over by a previous server
+    if (bind(server, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0
+            || listen(server, 16) != 0) {
+        std::cerr << "Unable to listen on " << socketPath << ": " << strerror(errno) << std::endl;
+        close(server);
+        return false;
+    }
+
+    std::cerr << "serving on " << socketPath << std::endl;
+
+    for (;;) {
+        int client = accept(server, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+
+            std::cerr << "accept failed: " << strerror(errno) << std::endl;
+            close(server);
+            return false;
+        }
+
+        std::thread(&ModelServer::serveClient, this, client).detach();
+    }
+}
@@ -0,0 +1,96 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <list>
+#include <mutex>
+#include <memory>
+
+#include <sys/types.h>
+#include <time.h>
+
+#include <boost/unordered_map.hpp>
+#include <boost/cstdint.hpp>
+
+#include "lexer.h"
+
+class NProject;
+
+// Keeps parsed A2L files in memory for other tools and answers their
+// requests on a Unix domain socket, one request per line:
+//
+//   LOAD path              parses the file unless it is cached
+//   XDF path               the XDF of all characteristics
+//   SELECT NAME,... path   the XDF of the given characteristics
+//   QUERY NAME path        the kind of the object NAME
+//   RANGE BEGIN-END path   the characteristics at addresses in [BEGIN, END)
+//   USING NAME path        the characteristics using the compu method NAME
+//   REFS NAME path         the functions listing the object NAME, or the
+//                          sub-functions of the function NAME
+//   STATS                  the state of the cache
+//
+// A path is the rest of the line, so it may contain spaces. An answer is
+// either "OK <length>\n" followed by length bytes, or "ERR <message>\n".
+//
+// A cached model is reused while the file has the same modification time
+// and size; otherwise its content hash decides. The least recently used
+// models are dropped once they take more than the cache size. Every model
+// has its own symbol table, so its names are released with it, and its
+// size counts the arena, the maps, the indexes and the names.
+class ModelServer
+{
+public:
+    ModelServer(LexerBackend backend, std::size_t cacheSize);
+
+    // Listens on socketPath and answers every client in its own thread.
+    // Returns only on errors.
+    bool serve(const char* socketPath);
+
+    // Answers one request line. Returns false if the answer is an error.
+    bool handle(const std::string& request, std::string& answer);
+
+private:
+    // noncopyable
+    ModelServer(const ModelServer&);
+    ModelServer& operator=(const ModelServer&);
+
+    struct Model;
+    typedef std::shared_ptr<Model> ModelPtr;
+    typedef std::list<ModelPtr> ModelList;
+    typedef boost::unordered_map<std::string, ModelList::iterator> ModelIndex;
+
+    // handle() for a request on the file path
+    bool respond(const std::string& command, const std::string& name, const std::string& path,
+                 std::string& answer);
+
+    // the current model of path, parsed if needed; NULL on errors
+    ModelPtr acquire(const std::string& path, std::string& error);
+    void insert(const ModelPtr& model);
+    void serveClient(int client);
+
+    LexerBackend m_backend;
+    std::size_t m_cacheSize;
+
+    std::mutex m_mutex; // guards everything below
+    ModelList m_models; // most recently used first
+    ModelIndex m_index; // path -> position in m_models
+    std::size_t m_cachedBytes;
+    std::size_t m_hits;
+    std::size_t m_misses;
+};
@@ -14,49 +14,49 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <charconv>
+
 #include "node.h"
+#include "descriptorPool.h"
 
-int NFormat::getDecimalPl() const
+Format parseFormat(const StringRef& format)
 {
-    unsigned int pos = format.find('.');
-    if (pos == format.npos) throw std::invalid_argument("Format string");
-
-    ++pos;
-    if (pos >= format.length()) throw std::out_of_range("Format string");
+    // "%Length.Layout", e.g. %5.2
+    const char* pos = format.data;
+    const char* end = format.data + format.length;
+    if (pos != end && *pos == '%') ++pos;
 
-    int decimalPl = atoi(format.substr(pos).c_str());
-    return decimalPl;
-}
+    int length = 0, decimalPl = 0;
+    pos = std::from_chars(pos, end, length).ptr;
 
-// specialization for our axis-types
-template<>
-AxisStyle NMap<NComAxis>::axisStyle()
-{
-    return Extern;
-}
+    if (pos == end || *pos != '.' || pos + 1 == end) {
+        std::cerr << "Invalid FORMAT \"" << format << "\", assuming 0 decimal places" << std::endl;
+    }
+    else {
+        std::from_chars(pos + 1, end, decimalPl); // like atoi, 0 if there are no digits
+    }
 
-template<>
-AxisStyle NMap<NStdAxis>::axisStyle()
-{
-    return Intern;
+    Format result = { static_cast<short>(length), static_cast<short>(decimalPl) };
+    return result;
 }
 
-template<>
-AxisStyle NMap<NFixAxis>::axisStyle()
+Format emptyFormat()
 {
-    return Fixed;
+    Format result = { 0, -1 };
+    return result;
 }
 
 NBaseMap* createMap(
-    NIdentifier* id,
-    const std::string& description,
-    NAddress* address,
-    NIdentifier* recordLayout,
+    Arena& arena,
+    Symbol id,
+    const StringRef& description,
+    unsigned long address,
+    Symbol recordLayout,
     double scale,
-    NIdentifier* compuMethod,
+    Symbol compuMethod,
     double min,
     double max,
-    NFormat* format,
+    const Format& format,
     NAxis* axis_1,
     NAxis* axis_2)
 {
@@ -70,7 +70,7 @@ NBaseMap* createMap(
 
     NBaseMap* map;
     if (style1 == Extern) {
-        map = new NMap<NComAxis>(id,
+        map = new (arena) NMap<NComAxis>(id,
                                  description,
                                  address,
                                  recordLayout,
@@ -83,7 +83,7 @@ NBaseMap* createMap(
                                  dynamic_cast<NComAxis*>(axis_2));
     }
     else if (style1 == Intern) {
-        map = new NMap<NStdAxis>(id,
+        map = new (arena) NMap<NStdAxis>(id,
                                  description,
                                  address,
                                  recordLayout,
@@ -96,7 +96,7 @@ NBaseMap* createMap(
                                  dynamic_cast<NStdAxis*>(axis_2));
     }
     else if (style1 == Fixed) {
-        map = new NMap<NFixAxis>(id,
+        map = new (arena) NMap<NFixAxis>(id,
                                  description,
                                  address,
                                  recordLayout,
@@ -111,27 +111,86 @@ NBaseMap* createMap(
     return map;
 }
 
+namespace {
+
+// counts the objects of each map, so they are allocated only once
+class ObjectCounter : public Visitor
+{
+public:
+    std::size_t characteristics, axisPts, measurements, functions, compuMethods, recordLayouts;
+
+    ObjectCounter() :
+        characteristics(0), axisPts(0), measurements(0),
+        functions(0), compuMethods(0), recordLayouts(0)
+    { }
+
+    void visit(NBaseMap* elem)              { ++characteristics; }
+    void visit(NCurve* elem)                { ++characteristics; }
+    void visit(NValue* elem)                { ++characteristics; }
+    void visit(NValBlk* elem)               { ++characteristics; }
+    void visit(NCharacteristicText* elem)   { ++characteristics; }
+
+    void visit(NAxisPts* elem)              { ++axisPts; }
+    void visit(NMeasurement* elem)          { ++measurements; }
+    void visit(NFunction* elem)             { ++functions; }
+    void visit(NCompuMethod* elem)          { ++compuMethods; }
+    void visit(NRecordLayout* elem)         { ++recordLayouts; }
+
+    void visit(NConstant* elem) { }
+    void visit(NVariable* elem) { }
+};
+
+} // namespace
+
+void NModule::reserveMaps(const StatementList& statements)
+{
+    ObjectCounter counter;
+    BOOST_FOREACH(StatementList::value_type i, statements) {
+        if (i != NULL) i->accept(counter);
+    }
+
+    characteristics.reserve(characteristics.size() + counter.characteristics);
+    axisPts.reserve(axisPts.size() + counter.axisPts);
+    measurements.reserve(measurements.size() + counter.measurements);
+    functions.reserve(functions.size() + counter.functions);
+    compuMethods.reserve(compuMethods.size() + counter.compuMethods);
+    recordLayouts.reserve(recordLayouts.size() + counter.recordLayouts);
+}
+
 const NRecordLayout::AxisLayout& NRecordLayout::getXAxis() const
 {
-    // if this cast fails somthing is terribly wrong
+    // if this fails somthing is terribly wrong
     // so let the caller handle this...
-    return dynamic_cast<const AxisLayout&>(*m_members.at(XAxis).get());
+    if (m_xAxis == NULL) throw std::out_of_range("RECORD_LAYOUT without x axis");
+    return *m_xAxis;
 }
 
 const NRecordLayout::AxisLayout& NRecordLayout::getYAxis() const
 {
     // same as above
-    return dynamic_cast<const AxisLayout&>(*m_members.at(YAxis).get());
+    if (m_yAxis == NULL) throw std::out_of_range("RECORD_LAYOUT without y axis");
+    return *m_yAxis;
 }
 
 const NRecordLayout::FncValues& NRecordLayout::getFncValues() const
 {
     // same as above
-    return dynamic_cast<const FncValues&>(*m_members.at(Fnc).get());
+    if (m_fncValues == NULL) throw std::out_of_range("RECORD_LAYOUT without FNC_VALUES");
+    return *m_fncValues;
+}
+
+static const NRecordLayout::AxisLayout* createAxisLayout(
+    Arena& arena, int NoAxisType, int ValAxisType, int flags, DescriptorPool* descriptors)
+{
+    if (descriptors != NULL) {
+        return descriptors->axisLayout(NoAxisType, ValAxisType, flags);
+    }
+    return new (arena) NRecordLayout::AxisLayout(NoAxisType, ValAxisType, flags);
 }
 
 NRecordLayout* NRecordLayout::createRecordLayout(
-    NIdentifier* id,
+    Arena& arena,
+    Symbol id,
     NRecordLayout::FncValues* fncValues)
 {
     if (fncValues == NULL) {
@@ -140,55 +199,52 @@ NRecordLayout* NRecordLayout::createRecordLayout(
     }
 
     // the simplest case is only a FNC_VALUES record
-    NRecordLayout* recordLayout = new NRecordLayout(id);
-    recordLayout->m_members[NRecordLayout::Fnc] = RecordPtr(fncValues);
+    NRecordLayout* recordLayout = new (arena) NRecordLayout(id);
+    recordLayout->m_fncValues = fncValues;
 
     return recordLayout;
 }
 
 NRecordLayout* NRecordLayout::createRecordLayout(
-    NIdentifier* id,
+    Arena& arena,
+    Symbol id,
     int NoAxisTypeX,
     int ValAxisTypeX,
     int AxisFlagsX,
-    NRecordLayout::FncValues* fncValues)
+    NRecordLayout::FncValues* fncValues,
+    DescriptorPool* descriptors)
 {
-    NRecordLayout* recordLayout = new NRecordLayout(id);
+    NRecordLayout* recordLayout = new (arena) NRecordLayout(id);
 
     // a fixed curve may be defined without FNC_VALUES
-    if (fncValues != NULL) {
-        recordLayout->m_members[NRecordLayout::Fnc] = RecordPtr(fncValues);
-    }
-
-    AxisLayout* xAxis = new AxisLayout(NoAxisTypeX, ValAxisTypeX, AxisFlagsX);
-    recordLayout->m_members[NRecordLayout::XAxis] = RecordPtr(xAxis);
+    recordLayout->m_fncValues = fncValues;
+    recordLayout->m_xAxis = createAxisLayout(arena, NoAxisTypeX, ValAxisTypeX, AxisFlagsX, descriptors);
 
     return recordLayout;
 }
 
 NRecordLayout* NRecordLayout::createRecordLayout(
-    NIdentifier* id,
+    Arena& arena,
+    Symbol id,
     int NoAxisTypeX,
     int ValAxisTypeX,
     int AxisFlagsX,
     int NoAxisTypeY,
     int ValAxisTypeY,
     int AxisFlagsY,
-    NRecordLayout::FncValues* fncValues)
+    NRecordLayout::FncValues* fncValues,
+    DescriptorPool* descriptors)
 {
     if (fncValues == NULL) {
         std::cerr << "A RECORD_LAYOUT for a map should have FNC_VALUES!" << std::endl;
         return NULL;
     }
 
-    NRecordLayout* recordLayout = new NRecordLayout(id);
-
-    AxisLayout* xAxis = new AxisLayout(NoAxisTypeX, ValAxisTypeX, AxisFlagsX);
-    AxisLayout* yAxis = new AxisLayout(NoAxisTypeY, ValAxisTypeY, AxisFlagsY);
+    NRecordLayout* recordLayout = new (arena) NRecordLayout(id);
 
-    recordLayout->m_members[NRecordLayout::XAxis] = RecordPtr(xAxis);
-    recordLayout->m_members[NRecordLayout::YAxis] = RecordPtr(yAxis);
-    recordLayout->m_members[NRecordLayout::Fnc] = RecordPtr(fncValues);
+    recordLayout->m_xAxis = createAxisLayout(arena, NoAxisTypeX, ValAxisTypeX, AxisFlagsX, descriptors);
+    recordLayout->m_yAxis = createAxisLayout(arena, NoAxisTypeY, ValAxisTypeY, AxisFlagsY, descriptors);
+    recordLayout->m_fncValues = fncValues;
 
     return recordLayout;
 }
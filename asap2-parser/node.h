@@ -19,19 +19,31 @@
 #include <iostream>
 #include <vector>
 #include <utility>
+#include <algorithm>
 #include <cstdio>
-#include <boost/checked_delete.hpp>
+#include <stdexcept>
 #include <boost/foreach.hpp>
 #include <boost/unordered_map.hpp>
-#include <boost/shared_ptr.hpp>
 #include <boost/static_assert.hpp>
 
 #include "util.h"
+#include "arena.h"
+#include "symbolTable.h"
 #include "owner_ptr.hpp"
-#include <map>
+#include "symbolMap.h"
 
 enum AxisStyle { Extern, Intern, Fixed };
 
+// the concrete type of an NCharacteristic, see dispatchCharacteristic()
+enum CharacteristicKind
+{
+    MapKind,
+    CurveKind,
+    ValueKind,
+    ValBlkKind,
+    AsciiKind
+};
+
 class NStatement;
 class NExpression;
 
@@ -56,15 +68,20 @@ class NRecordLayout;
 class NConstant;
 class NVariable;
 
-typedef std::vector<NStatement*> StatementList;
-typedef std::vector<NExpression*> ExpressionList;
+class DescriptorPool;
+
+// lists of the tree are allocated in its Arena as well
+typedef std::vector<NStatement*, ArenaAllocator<NStatement*> > StatementList;
+typedef std::vector<NExpression*, ArenaAllocator<NExpression*> > ExpressionList;
+typedef std::vector<Symbol, ArenaAllocator<Symbol> > SymbolList;
 
-typedef boost::unordered_map<std::string, NCharacteristic*> CharacteristicHashMap;
-typedef boost::unordered_map<std::string, NAxisPts*> AxisPtsHashMap;
-typedef boost::unordered_map<std::string, NMeasurement*> MeasurementHashMap;
-typedef boost::unordered_map<std::string, NFunction*> FunctionHashMap;
-typedef boost::unordered_map<std::string, NCompuMethod*> CompuMethodHashMap;
-typedef boost::unordered_map<std::string, NRecordLayout*> RecordLayoutHashMap;
+// the objects of a module by name, in the order of the input
+typedef SymbolMap<NCharacteristic> CharacteristicHashMap;
+typedef SymbolMap<NAxisPts> AxisPtsHashMap;
+typedef SymbolMap<NMeasurement> MeasurementHashMap;
+typedef SymbolMap<NFunction> FunctionHashMap;
+typedef SymbolMap<NCompuMethod> CompuMethodHashMap;
+typedef SymbolMap<NRecordLayout> RecordLayoutHashMap;
 
 class Visitor
 {
@@ -96,6 +113,12 @@ public:
     Node() : m_parent(0) { }
     virtual ~Node() { }
 
+    // Nodes are allocated in the Arena of their tree and are released
+    // all at once with it; deleting a single node frees nothing.
+    static void* operator new(std::size_t size, Arena& arena) { return arena.allocate(size); }
+    static void operator delete(void*, Arena&) { }
+    static void operator delete(void*) { }
+
     const Node* getParent() const
     {
         return m_parent;
@@ -137,34 +160,28 @@ class NAddress : public NNumeric {
 public:
     unsigned long value;
     explicit NAddress(unsigned long value) : value(value) { }
-    explicit NAddress(const std::string& str)
-    {
-        std::string addr = getAddressSubstr(str); // remove leading '"0x' and rear '"' characters
-
-        char* p;
-        value = strtoul(addr.c_str(), &p, 16); // addresses are hexadecimal
-        if (*p != 0) {
-            std::cerr << "Invalid address: " << str << std::endl;
-        }
-    }
 };
 
 class NStringLiteral : public NExpression {
 public:
-    std::string string;
-    explicit NStringLiteral(const std::string& string) : string(string) { }
+    StringRef string;
+    explicit NStringLiteral(const StringRef& string) : string(string) { }
 };
 
 class NIdentifier : public NExpression {
 public:
-    const std::string name;
-    NIdentifier(const std::string& name) : name(name) { }
+    const Symbol symbol;
+    explicit NIdentifier(Symbol symbol) : symbol(symbol) { }
+
+    const std::string& name() const { return symbols().name(symbol); }
 };
 
 class NStatement : public Node {
 public:
-    owner_ptr<NIdentifier, Node> id;
-    NStatement(NIdentifier* id) : id(id, this) { }
+    Symbol id;
+    NStatement(Symbol id) : id(id) { }
+
+    const std::string& name() const { return symbols().name(id); }
 
     virtual void accept(Visitor& v) = 0;
 };
@@ -173,14 +190,7 @@ class NBlock : public NExpression {
 public:
     StatementList statements;
 
-    NBlock() { }
-
-    ~NBlock()
-    {
-        BOOST_FOREACH (StatementList::value_type i, statements) {
-            boost::checked_delete(i);
-        }
-    }
+    explicit NBlock(Arena& arena) : statements(arena) { }
 };
 
 
@@ -189,7 +199,7 @@ class NVariable : public NStatement {
 public:
     NExpression* assignmentExpr; // consider this as weak ref
 
-    NVariable(NIdentifier* id) : NStatement(id) { }
+    NVariable(Symbol id) : NStatement(id) { }
 
     void accept(Visitor& v) { v.visit(this); }
 };
@@ -198,40 +208,49 @@ class NConstant : public NStatement {
 public:
     const NExpression& assignmentExpr;
 
-    NConstant(NIdentifier* id, const NExpression& assignmentExpr) :
+    NConstant(Symbol id, const NExpression& assignmentExpr) :
         NStatement(id), assignmentExpr(assignmentExpr) { }
 
     void accept(Visitor& v) { v.visit(this); }
 };
 
 ////////////
-class NFormat : public NExpression {
-public:
-    std::string format;
-    NFormat(const std::string& format) : format(format) { }
+// FORMAT "%Length.Layout", parsed once when it is read
+struct Format {
+    short length;
+    short decimalPl; // -1 if the object has no FORMAT
 
-    int getDecimalPl() const;
+    bool empty() const { return (decimalPl < 0); }
 };
 
+Format parseFormat(const StringRef& format);
+Format emptyFormat();
+
 class NAxis : public NExpression { // declaration
 public:
-    owner_ptr<NIdentifier, Node> m_dataType;
-    owner_ptr<NIdentifier, Node> m_compuMethod;
+    Symbol dataType;
+    Symbol compuMethod;
     int length;
     double min;
     double max;
 
+    // resolved by linkModule(), NULL if the name is not defined
+    const NMeasurement* dataTypeRef;
+    const NCompuMethod* compuMethodRef;
+
     NAxis(
-        NIdentifier* ident,
-        NIdentifier* compuMethod,
+        Symbol dataType,
+        Symbol compuMethod,
         int length,
         double min,
         double max) :
-        m_dataType(ident, this),
-        m_compuMethod(compuMethod, this),
+        dataType(dataType),
+        compuMethod(compuMethod),
         length(length),
         min(min),
-        max(max) { }
+        max(max),
+        dataTypeRef(NULL),
+        compuMethodRef(NULL) { }
 
     AxisStyle getAxisStyle() const { return m_axisStyle; }
 
@@ -241,116 +260,143 @@ protected:
 
 class NComAxis : public NAxis { // declaration
 public:
-    owner_ptr<NIdentifier, Node> m_axis_pts;
+    Symbol axisPts;
+    const NAxisPts* axisPtsRef; // resolved by linkModule()
 
     NComAxis(
-        NIdentifier* dataType,
-        NIdentifier* compuMethod,
+        Symbol dataType,
+        Symbol compuMethod,
         int length,
         double min,
         double max,
-        NIdentifier* axis_pts) :
+        Symbol axisPts) :
         NAxis(dataType, compuMethod, length, min, max),
-        m_axis_pts(axis_pts, this)
-    { m_axisStyle = Extern; }
+        axisPts(axisPts),
+        axisPtsRef(NULL)
+    { m_axisStyle = style; }
+
+    static const AxisStyle style = Extern;
 };
 
 class NStdAxis : public NAxis { // declaration
 public:
-    owner_ptr<NFormat, Node> m_format;
+    Format format;
     /* NDeposite */
 
     NStdAxis(
-        NIdentifier* dataType,
-        NIdentifier* compuMethod,
+        Symbol dataType,
+        Symbol compuMethod,
         int length,
         double min,
         double max,
-        NFormat* format) :
+        const Format& format) :
         NAxis(dataType, compuMethod, length, min, max),
-        m_format(format, this)
-    { m_axisStyle = Intern; }
+        format(format)
+    { m_axisStyle = style; }
+
+    static const AxisStyle style = Intern;
 };
 
 class NFixAxis : public NAxis { // declaration
 public:
-    owner_ptr<NFormat, Node> m_format;
+    Format format;
     /* FIX_AXIS_PAR */
 
     NFixAxis(
-        NIdentifier* dataType,
-        NIdentifier* compuMethod,
+        Symbol dataType,
+        Symbol compuMethod,
         int length,
         double min,
         double max,
-        NFormat* format) :
+        const Format& format) :
         NAxis(dataType, compuMethod, length, min, max),
-        m_format(format, this)
-    { m_axisStyle = Fixed; }
+        format(format)
+    { m_axisStyle = style; }
+
+    static const AxisStyle style = Fixed;
 };
 //////////////////
 
 class NCharacteristic : public NStatement { // declaration
 public:
-    std::string description;
-    owner_ptr<NAddress, Node> m_address;
-    owner_ptr<NIdentifier, Node> m_recordLayout;
+    // ordered by size, so the members pack without padding
+    Symbol recordLayout;
+    Symbol compuMethod;
+    unsigned long address;
+    StringRef description;
     double scale;
-    owner_ptr<NIdentifier, Node> m_compuMethod;
     double min;
     double max;
-    owner_ptr<NFormat, Node, /* optional */ true> m_format;
+    Format format; // optional
+
+    // resolved by linkModule(), NULL if the name is not defined
+    const NRecordLayout* recordLayoutRef;
+    const NCompuMethod* compuMethodRef;
+    bool linked;
+
+    const CharacteristicKind kind;
 
     NCharacteristic(
-        NIdentifier* id,
-        const std::string& description,
-        NAddress* address,
-        NIdentifier* recordLayout,
+        CharacteristicKind kind,
+        Symbol id,
+        const StringRef& description,
+        unsigned long address,
+        Symbol recordLayout,
         double scale,
-        NIdentifier* compuMethod,
+        Symbol compuMethod,
         double min,
         double max,
-        NFormat* format) :
-        NStatement(id), description(description), m_address(address, this),
-        m_recordLayout(recordLayout, this), scale(scale),
-        m_compuMethod(compuMethod, this), min(min), max(max),
-        m_format(format, this)
+        const Format& format) :
+        NStatement(id), recordLayout(recordLayout), compuMethod(compuMethod),
+        address(address), description(description), scale(scale),
+        min(min), max(max), format(format),
+        recordLayoutRef(NULL), compuMethodRef(NULL), linked(false), kind(kind)
     { }
 };
 
 class NBaseMap : public NCharacteristic {
 public:
     NBaseMap(
-        NIdentifier* id,
-        const std::string& description,
-        NAddress* address,
-        NIdentifier* recordLayout,
+        AxisStyle axisStyle,
+        Symbol id,
+        const StringRef& description,
+        unsigned long address,
+        Symbol recordLayout,
         double scale,
-        NIdentifier* compuMethod,
+        Symbol compuMethod,
         double min,
         double max,
-        NFormat* format) :
-        NCharacteristic(id, description, address, recordLayout, scale, compuMethod, min, max, format)
+        const Format& format) :
+        NCharacteristic(MapKind, id, description, address, recordLayout, scale, compuMethod, min, max, format),
+        m_axisStyle(axisStyle)
     { }
 
     void accept(Visitor& v) { v.visit(this); }
 
 public:
-    virtual AxisStyle axisStyle() = 0;
+    // the axis type of the NMap, see dispatchMap()
+    AxisStyle axisStyle() const { return m_axisStyle; }
+
     virtual int axisXlength() = 0;
     virtual int axisYlength() = 0;
+    virtual NAxis* axisX() = 0;
+    virtual NAxis* axisY() = 0;
+
+private:
+    const AxisStyle m_axisStyle;
 };
 
 NBaseMap* createMap(
-    NIdentifier* id,
-    const std::string& description,
-    NAddress* address,
-    NIdentifier* recordLayout,
+    Arena& arena,
+    Symbol id,
+    const StringRef& description,
+    unsigned long address,
+    Symbol recordLayout,
     double scale,
-    NIdentifier* compuMethod,
+    Symbol compuMethod,
     double min,
     double max,
-    NFormat* format,
+    const Format& format,
     NAxis* axis_1,
     NAxis* axis_2);
 
@@ -363,24 +409,25 @@ public:
 
     // achsen müssen den gleichen typen besitzen!
     NMap(
-        NIdentifier* id,
-        const std::string& description,
-        NAddress* address,
-        NIdentifier* recordLayout,
+        Symbol id,
+        const StringRef& description,
+        unsigned long address,
+        Symbol recordLayout,
         double scale,
-        NIdentifier* compuMethod,
+        Symbol compuMethod,
         double min,
         double max,
-        NFormat* format,
+        const Format& format,
         T * axis_1,
         T * axis_2) :
-        NBaseMap(id, description, address, recordLayout, scale, compuMethod, min, max, format),
+        NBaseMap(T::style, id, description, address, recordLayout, scale, compuMethod, min, max, format),
         m_axis_1(axis_1, this), m_axis_2(axis_2, this)
     { }
 
-    virtual AxisStyle axisStyle();
     virtual int axisXlength() { return m_axis_1->length; }
     virtual int axisYlength() { return m_axis_2->length; }
+    virtual NAxis* axisX() { return m_axis_1.get(); }
+    virtual NAxis* axisY() { return m_axis_2.get(); }
 };
 
 class NCurve : public NCharacteristic { // declaration
@@ -388,17 +435,17 @@ public:
     owner_ptr<NAxis, Node> m_axis_1;
 
     NCurve(
-        NIdentifier* id,
-        const std::string& description,
-        NAddress* address,
-        NIdentifier* recordLayout,
+        Symbol id,
+        const StringRef& description,
+        unsigned long address,
+        Symbol recordLayout,
         double scale,
-        NIdentifier* compuMethod,
+        Symbol compuMethod,
         double min,
         double max,
-        NFormat* format,
+        const Format& format,
         NAxis* axis_1) :
-        NCharacteristic(id, description, address, recordLayout, scale, compuMethod, min, max, format),
+        NCharacteristic(CurveKind, id, description, address, recordLayout, scale, compuMethod, min, max, format),
         m_axis_1(axis_1, this)
     { }
 
@@ -408,16 +455,16 @@ public:
 class NValue : public NCharacteristic { // declaration
 public:
     NValue(
-        NIdentifier* id,
-        const std::string& description,
-        NAddress* address,
-        NIdentifier* recordLayout,
+        Symbol id,
+        const StringRef& description,
+        unsigned long address,
+        Symbol recordLayout,
         double scale,
-        NIdentifier* compuMethod,
+        Symbol compuMethod,
         double min,
         double max,
-        NFormat* format) :
-        NCharacteristic(id, description, address, recordLayout, scale, compuMethod, min, max, format)
+        const Format& format) :
+        NCharacteristic(ValueKind, id, description, address, recordLayout, scale, compuMethod, min, max, format)
     { }
 
     void accept(Visitor& v) { v.visit(this); }
@@ -428,17 +475,17 @@ public:
     int m_number;
 
     NValBlk(
-        NIdentifier* id,
-        const std::string& description,
-        NAddress* address,
-        NIdentifier* recordLayout,
+        Symbol id,
+        const StringRef& description,
+        unsigned long address,
+        Symbol recordLayout,
         double scale,
-        NIdentifier* compuMethod,
+        Symbol compuMethod,
         double min,
         double max,
-        NFormat* format,
+        const Format& format,
         int number) :
-        NCharacteristic(id, description, address, recordLayout, scale, compuMethod, min, max, format),
+        NCharacteristic(ValBlkKind, id, description, address, recordLayout, scale, compuMethod, min, max, format),
         m_number(number)
     { }
 
@@ -450,17 +497,17 @@ public:
     int m_size;
 
     NCharacteristicText(
-        NIdentifier* id,
-        const std::string& description,
-        NAddress* address,
-        NIdentifier* recordLayout,
+        Symbol id,
+        const StringRef& description,
+        unsigned long address,
+        Symbol recordLayout,
         double scale,
-        NIdentifier* compuMethod,
+        Symbol compuMethod,
         double min,
         double max,
-        NFormat* format,
+        const Format& format,
         int size) :
-        NCharacteristic(id, description, address, recordLayout, scale, compuMethod, min, max, format),
+        NCharacteristic(AsciiKind, id, description, address, recordLayout, scale, compuMethod, min, max, format),
         m_size(size)
     { }
 
@@ -468,28 +515,57 @@ public:
 };
 ////////
 
+// Static dispatch: calls f with the concrete type of an object, selected by
+// a switch on its type tag instead of a virtual call or a dynamic_cast. f is
+// a generic lambda or an object with an operator() for each type.
+
+// calls f with the NMap<axis type> of map
+template<class F>
+void dispatchMap(NBaseMap& map, F&& f)
+{
+    switch (map.axisStyle()) {
+    case Extern: f(static_cast<NMap<NComAxis>&>(map)); break;
+    case Intern: f(static_cast<NMap<NStdAxis>&>(map)); break;
+    case Fixed: f(static_cast<NMap<NFixAxis>&>(map)); break;
+    }
+}
+
+// maps are passed on to dispatchMap()
+template<class F>
+void dispatchCharacteristic(NCharacteristic& characteristic, F&& f)
+{
+    switch (characteristic.kind) {
+    case MapKind: dispatchMap(static_cast<NBaseMap&>(characteristic), f); break;
+    case CurveKind: f(static_cast<NCurve&>(characteristic)); break;
+    case ValueKind: f(static_cast<NValue&>(characteristic)); break;
+    case ValBlkKind: f(static_cast<NValBlk&>(characteristic)); break;
+    case AsciiKind: f(static_cast<NCharacteristicText&>(characteristic)); break;
+    }
+}
+////////
+
 class NMeasurement : public NStatement { // declaration
 public:
-    std::string description;
     int dataType;
+    StringRef description;
     int int1, int2; // these are always 0 and 100; i don't know for what they are
-    owner_ptr<NNumeric, Node> m_min;
-    owner_ptr<NNumeric, Node> m_max;
-    owner_ptr<NFormat, Node> m_format;
-    owner_ptr<NAddress, Node> m_address;
+    Format format;
+    double min;
+    double max;
+    unsigned long address;
 
     NMeasurement(
-        NIdentifier* id,
-        const std::string& description,
+        Symbol id,
+        const StringRef& description,
         int dataType,
         int int1, int int2,
-        NNumeric* min,
-        NNumeric* max,
-        NFormat* format,
-        NAddress* address) :
-        NStatement(id), description(description), dataType(dataType),
-        int1(int1), int2(int2), m_min(min, this), m_max(max, this),
-        m_format(format, this), m_address(address, this)
+        double min,
+        double max,
+        const Format& format,
+        unsigned long address) :
+        NStatement(id), dataType(dataType), description(description),
+        int1(int1), int2(int2), format(format), min(min), max(max),
+        address(address)
     { }
 
     void accept(Visitor& v) { v.visit(this); }
@@ -497,18 +573,18 @@ public:
 
 class NMeasurementBit : public NMeasurement { // declaration
 public:
-    std::string bitMask; // TODO: change type
+    unsigned long bitMask;
 
     NMeasurementBit(
-        NIdentifier* id,
-        const std::string& description,
+        Symbol id,
+        const StringRef& description,
         int dataType,
         int int1, int int2,
-        NNumeric* min,
-        NNumeric* max,
-        NFormat* format,
-        NAddress* address,
-        const std::string& bitMask) :
+        double min,
+        double max,
+        const Format& format,
+        unsigned long address,
+        unsigned long bitMask) :
         NMeasurement(id, description, dataType, int1, int2, min, max,format, address),
         bitMask(bitMask)
     { }
@@ -516,21 +592,21 @@ public:
 
 class NMeasurementValue : public NMeasurement { // declaration
 public:
-    owner_ptr<NIdentifier, Node> m_type; // samples: dez, t10msxs_ub_b2p55
+    Symbol type; // samples: dez, t10msxs_ub_b2p55
     // TODO: bitmask
 
     NMeasurementValue(
-        NIdentifier* id,
-        const std::string& description,
+        Symbol id,
+        const StringRef& description,
         int dataType,
         int int1, int int2,
-        NNumeric* min,
-        NNumeric* max,
-        NFormat* format,
-        NAddress* address,
-        NIdentifier* type) :
+        double min,
+        double max,
+        const Format& format,
+        unsigned long address,
+        Symbol type) :
         NMeasurement(id, description, dataType, int1, int2, min, max,format, address),
-        m_type(type, this)
+        type(type)
     { }
 };
 
@@ -539,15 +615,15 @@ public:
     int arraySize;
 
     NMeasurementArray(
-        NIdentifier* id,
-        const std::string& description,
+        Symbol id,
+        const StringRef& description,
         int dataType,
         int int1, int int2,
-        NNumeric* min,
-        NNumeric* max,
-        NFormat* format,
-        NAddress* address,
-        NIdentifier* type,
+        double min,
+        double max,
+        const Format& format,
+        unsigned long address,
+        Symbol type,
         int arraySize) :
         NMeasurementValue(id, description, dataType, int1, int2, min, max, format, address, type),
         arraySize(arraySize)
@@ -557,33 +633,32 @@ public:
 
 class NAxisPts : public NStatement {
 public:
-    std::string description;
-    owner_ptr<NAddress, Node> m_address;
-    owner_ptr<NIdentifier, Node> m_unit;
-    owner_ptr<NIdentifier, Node> m_ident;
-    double scale;
-    owner_ptr<NIdentifier, Node> m_type;
+    Symbol unit;
+    Symbol ident;
+    Symbol type;
     int size;
+    StringRef description;
+    unsigned long address;
+    double scale;
     double min;
     double max;
-    owner_ptr<NFormat, Node> m_format;
+    Format format;
 
     NAxisPts(
-        NIdentifier* id,
-        const std::string& description,
-        NAddress* address,
-        NIdentifier* unit,
-        NIdentifier* ident,
+        Symbol id,
+        const StringRef& description,
+        unsigned long address,
+        Symbol unit,
+        Symbol ident,
         double scale,
-        NIdentifier* type,
+        Symbol type,
         int size,
         double min,
         double max,
-        NFormat* format) :
-        NStatement(id), description(description), m_address(address, this),
-        m_unit(unit, this), m_ident(ident, this), scale(scale),
-        m_type(type, this), size(size), min(min), max(max),
-        m_format(format, this)
+        const Format& format) :
+        NStatement(id), unit(unit), ident(ident), type(type), size(size),
+        description(description), address(address), scale(scale),
+        min(min), max(max), format(format)
     { }
 
     void accept(Visitor& v) { v.visit(this); }
@@ -593,32 +668,21 @@ public:
 
 class NCompuMethod : public NStatement {
 public:
-    std::string description;
-    owner_ptr<NFormat, Node> m_format;
-    std::string unit;
-    owner_ptr<NNumeric, Node> m_number1;
-    owner_ptr<NNumeric, Node> m_number2;
-    owner_ptr<NNumeric, Node> m_number3;
-    owner_ptr<NNumeric, Node> m_number4;
-    owner_ptr<NNumeric, Node> m_number5;
-    owner_ptr<NNumeric, Node> m_number6;
+    Format format;
+    StringRef description;
+    StringRef unit;
+    double coeffs[6]; // RAT_FUNC: (a*x^2 + b*x + c) / (d*x^2 + e*x + f)
 
     NCompuMethod(
-        NIdentifier* id,
-        const std::string& description,
-        NFormat* format,
-        const std::string& unit,
-        NNumeric* number1,
-        NNumeric* number2,
-        NNumeric* number3,
-        NNumeric* number4,
-        NNumeric* number5,
-        NNumeric* number6) :
-        NStatement(id), description(description), m_format(format, this),
-        unit(unit), m_number1(number1, this), m_number2(number2, this),
-        m_number3(number3, this), m_number4(number4, this),
-        m_number5(number5, this), m_number6(number6, this)
-    { }
+        Symbol id,
+        const StringRef& description,
+        const Format& format,
+        const StringRef& unit,
+        const double (&coeffs)[6]) :
+        NStatement(id), format(format), description(description), unit(unit)
+    {
+        std::copy(coeffs, coeffs + 6, this->coeffs);
+    }
 
     void accept(Visitor& v) { v.visit(this); }
 };
@@ -627,24 +691,24 @@ public:
 
 class NFunction : public NStatement {
 public:
-    std::string description;
+    StringRef description;
 
-    ExpressionList* def_characteristic;
-    ExpressionList* ref_characteristic;
-    ExpressionList* in_measurement;
-    ExpressionList* out_measurement;
-    ExpressionList* loc_measurement;
-    ExpressionList* sub_function;
+    SymbolList* def_characteristic;
+    SymbolList* ref_characteristic;
+    SymbolList* in_measurement;
+    SymbolList* out_measurement;
+    SymbolList* loc_measurement;
+    SymbolList* sub_function;
 
     NFunction(
-        NIdentifier* id,
-        const std::string& description,
-        ExpressionList* def_characteristic,
-        ExpressionList* ref_characteristic,
-        ExpressionList* in_measurement,
-        ExpressionList* out_measurement,
-        ExpressionList* loc_measurement,
-        ExpressionList* sub_function) :
+        Symbol id,
+        const StringRef& description,
+        SymbolList* def_characteristic,
+        SymbolList* ref_characteristic,
+        SymbolList* in_measurement,
+        SymbolList* out_measurement,
+        SymbolList* loc_measurement,
+        SymbolList* sub_function) :
         NStatement(id), description(description),
         def_characteristic(def_characteristic),
         ref_characteristic(ref_characteristic),
@@ -654,17 +718,6 @@ public:
         sub_function(sub_function)
     { }
 
-    ~NFunction()
-    {
-        // delete our child nodes
-        deleteAndClear(*def_characteristic);
-        deleteAndClear(*ref_characteristic);
-        deleteAndClear(*in_measurement);
-        deleteAndClear(*out_measurement);
-        deleteAndClear(*loc_measurement);
-        deleteAndClear(*sub_function);
-    }
-
     void accept(Visitor& v) { v.visit(this); }
 };
 
@@ -673,13 +726,9 @@ public:
 class NRecordLayout : public NStatement {
 private:
     class RecordMember : public Node { };
-    enum MemberType { XAxis, YAxis, Fnc };
-    typedef boost::shared_ptr<RecordMember> RecordPtr;
-    std::map<MemberType, RecordPtr> m_members; // RECORD_LAYOUT members vary in all posible ways
-
 public:
-    NRecordLayout(NIdentifier* id) :
-        NStatement(id) { }
+    NRecordLayout(Symbol id) :
+        NStatement(id), m_xAxis(0), m_yAxis(0), m_fncValues(0) { }
 
     class AxisLayout : public RecordMember
     {
@@ -706,52 +755,89 @@ public:
 
     void accept(Visitor& v) { v.visit(this); }
 
-    bool hasFncValues() const { return true; } // FIXME
-    bool hasXAxis() const { return true; } // FIXME
-    bool hasYAxis() const { return true; } // FIXME
+    bool hasFncValues() const { return (m_fncValues != 0); }
+    bool hasXAxis() const { return (m_xAxis != 0); }
+    bool hasYAxis() const { return (m_yAxis != 0); }
 
     const AxisLayout& getXAxis() const;
     const AxisLayout& getYAxis() const;
     const FncValues& getFncValues() const;
 
-    // static members
+    // static members; the axis layouts are shared by way of descriptors
+    // if it is given
     static NRecordLayout* createRecordLayout(
-        NIdentifier* id,
+        Arena& arena,
+        Symbol id,
         NRecordLayout::FncValues* fncValues);
 
     static NRecordLayout* createRecordLayout(
-        NIdentifier* id,
+        Arena& arena,
+        Symbol id,
         int NoAxisTypeX,
         int ValAxisTypeX,
         int AxisFlagsX,
-        NRecordLayout::FncValues* fncValues);
+        NRecordLayout::FncValues* fncValues,
+        DescriptorPool* descriptors = NULL);
 
     static NRecordLayout* createRecordLayout(
-        NIdentifier* id,
+        Arena& arena,
+        Symbol id,
         int NoAxisTypeX,
         int ValAxisTypeX,
         int AxisFlagsX,
         int NoAxisTypeY,
         int ValAxisTypeY,
         int AxisFlagsY,
-        NRecordLayout::FncValues* fncValues);
+        NRecordLayout::FncValues* fncValues,
+        DescriptorPool* descriptors = NULL);
+
+private:
+    // RECORD_LAYOUT members vary in all posible ways, missing ones are NULL
+    const AxisLayout* m_xAxis;
+    const AxisLayout* m_yAxis;
+    const FncValues* m_fncValues;
 };
 ///////////////
 
 class NHeader : public NExpression {
 public:
-    std::string name;
-    std::string model;
+    StringRef name;
+    StringRef model;
     owner_ptr<NIdentifier, Node> m_project;
 
     NHeader(
-        const std::string& name,
-        const std::string& model,
+        const StringRef& name,
+        const StringRef& model,
         NIdentifier* project) :
         name(name), model(model), m_project(project, this)
     { }
 };
 
+// the kinds of objects a module can look up by name
+enum ObjectKind
+{
+    CharacteristicObject,
+    MeasurementObject,
+    AxisPtsObject,
+    CompuMethodObject,
+    RecordLayoutObject,
+    FunctionObject
+};
+
+// Parses objects of a module when they are looked up for the first time,
+// see parseProjectLazy().
+class ObjectLoader
+{
+public:
+    virtual ~ObjectLoader() { }
+
+    // adds the object to the module, false if there is no such object
+    virtual bool load(ObjectKind kind, Symbol id) = 0;
+
+    // adds all objects of a kind which are not loaded yet, false on errors
+    virtual bool loadAll(ObjectKind kind) = 0;
+};
+
 class NModule : public Node, public Visitor {
 public:
     owner_ptr<NBlock, Node> m_innerBlock;
@@ -767,30 +853,126 @@ public:
 
     NModule(
         NBlock* innerBlock) :
-        m_innerBlock(innerBlock, this)
+        m_innerBlock(innerBlock, this),
+        m_loader(NULL)
     { buildMaps(); }
 
-    void visit(NBaseMap* elem)              { characteristics[elem->id->name] = elem; }
-    void visit(NCurve* elem)                { characteristics[elem->id->name] = elem; }
-    void visit(NValue* elem)                { characteristics[elem->id->name] = elem; }
-    void visit(NValBlk* elem)               { characteristics[elem->id->name] = elem; }
-    void visit(NCharacteristicText* elem)   { characteristics[elem->id->name] = elem; }
+    // The objects by name, these throw std::out_of_range for unknown names.
+    // Unlike the maps, they also find objects which are not parsed yet.
+    NCharacteristic* getCharacteristic(Symbol id) const { return lookup(characteristics, CharacteristicObject, id); }
+    NAxisPts* getAxisPts(Symbol id) const               { return lookup(axisPts, AxisPtsObject, id); }
+    NMeasurement* getMeasurement(Symbol id) const       { return lookup(measurements, MeasurementObject, id); }
+    NFunction* getFunction(Symbol id) const             { return lookup(functions, FunctionObject, id); }
+    NCompuMethod* getCompuMethod(Symbol id) const       { return lookup(compuMethods, CompuMethodObject, id); }
+    NRecordLayout* getRecordLayout(Symbol id) const     { return lookup(recordLayouts, RecordLayoutObject, id); }
+
+    // like the getters, but NULL for unknown names
+    NCharacteristic* findCharacteristic(Symbol id) const { return find(characteristics, CharacteristicObject, id); }
+    NAxisPts* findAxisPts(Symbol id) const               { return find(axisPts, AxisPtsObject, id); }
+    NMeasurement* findMeasurement(Symbol id) const       { return find(measurements, MeasurementObject, id); }
+    NFunction* findFunction(Symbol id) const             { return find(functions, FunctionObject, id); }
+    NCompuMethod* findCompuMethod(Symbol id) const       { return find(compuMethods, CompuMethodObject, id); }
+    NRecordLayout* findRecordLayout(Symbol id) const     { return find(recordLayouts, RecordLayoutObject, id); }
+
+    // makes sure the maps contain all objects of a kind
+    bool loadAll(ObjectKind kind) const { return (m_loader == NULL) || m_loader->loadAll(kind); }
+
+    // the bytes of the maps, which are not in the arena
+    std::size_t memoryUsage() const
+    {
+        return characteristics.memoryUsage() + axisPts.memoryUsage() + measurements.memoryUsage()
+            + functions.memoryUsage() + compuMethods.memoryUsage() + recordLayouts.memoryUsage();
+    }
+
+    void setLoader(ObjectLoader* loader) { m_loader = loader; }
+
+    void visit(NBaseMap* elem)              { update(characteristics, elem); }
+    void visit(NCurve* elem)                { update(characteristics, elem); }
+    void visit(NValue* elem)                { update(characteristics, elem); }
+    void visit(NValBlk* elem)               { update(characteristics, elem); }
+    void visit(NCharacteristicText* elem)   { update(characteristics, elem); }
 
-    void visit(NAxisPts* elem)              { axisPts[elem->id->name] = elem; }
-    void visit(NMeasurement* elem)          { measurements[elem->id->name] = elem; }
-    void visit(NFunction* elem)             { functions[elem->id->name] = elem; }
-    void visit(NCompuMethod* elem)          { compuMethods[elem->id->name] = elem; }
-    void visit(NRecordLayout* elem)         { recordLayouts[elem->id->name] = elem; }
+    void visit(NAxisPts* elem)              { update(axisPts, elem); }
+    void visit(NMeasurement* elem)          { update(measurements, elem); }
+    void visit(NFunction* elem)             { update(functions, elem); }
+    void visit(NCompuMethod* elem)          { update(compuMethods, elem); }
+    void visit(NRecordLayout* elem)         { update(recordLayouts, elem); }
 
     // inner statements
     void visit(NConstant* elem) { std::cerr << "NConstant is invalid in this context!\n" << std::endl; }
     void visit(NVariable* elem) { std::cerr << "NVariable is invalid in this context!\n" << std::endl; }
 
+    // appends statements parsed separately, e.g. by a parallel parse
+    void addStatements(const StatementList& statements)
+    {
+        reserveMaps(statements);
+        BOOST_FOREACH(StatementList::value_type i, statements) {
+            addStatement(i);
+        }
+    }
+
+    void addStatement(NStatement* statement)
+    {
+        m_innerBlock->statements.push_back(statement);
+        addToMaps(statement);
+    }
+
+    // Fills the maps again from the inner block, after its statements were
+    // replaced by a re-parse. The entries get the order of a fresh parse.
+    void rebuildMaps()
+    {
+        characteristics.clear();
+        axisPts.clear();
+        measurements.clear();
+        functions.clear();
+        compuMethods.clear();
+        recordLayouts.clear();
+        buildMaps();
+    }
+
 private:
+    template<class Map>
+    typename Map::mapped_type find(const Map& map, ObjectKind kind, Symbol id) const
+    {
+        typename Map::const_iterator i = map.find(id);
+        if (i == map.end() && m_loader != NULL && m_loader->load(kind, id)) {
+            i = map.find(id); // the loader added it through addStatements()
+        }
+
+        return (i != map.end()) ? i->second : NULL;
+    }
+
+    template<class Map>
+    typename Map::mapped_type lookup(const Map& map, ObjectKind kind, Symbol id) const
+    {
+        typename Map::mapped_type object = find(map, kind, id);
+        if (object == NULL) {
+            throw std::out_of_range(symbols().name(id));
+        }
+        return object;
+    }
+
+    template<class Map, class T>
+    void update(Map& map, T* elem)
+    {
+        map[elem->id] = elem;
+    }
+
+    ObjectLoader* m_loader; // not owned, NULL if everything is parsed
+
+    // sizes the maps for statements in addition to the current entries
+    void reserveMaps(const StatementList& statements);
+
+    void addToMaps(NStatement* statement)
+    {
+        if (statement != NULL) statement->accept(*this);
+    }
+
     void buildMaps()
     {
+        reserveMaps(m_innerBlock->statements);
         BOOST_FOREACH(StatementList::value_type i, m_innerBlock->statements) {
-            if (i != NULL) i->accept(*this);
+            addToMaps(i);
         }
     }
 };
@@ -0,0 +1,138 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "outputSink.h"
+
+OutputSink::OutputSink(std::size_t capacity, std::size_t flushSize) :
+    m_buffer(capacity),
+    m_flushSize(flushSize),
+    m_fd(-1),
+    m_ownsFd(false),
+    m_failed(false)
+{
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+}
+
+OutputSink::~OutputSink()
+{
+    close();
+}
+
+bool OutputSink::open(const char* path)
+{
+    close();
+
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        std::cerr << "Unable to open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    m_fd = fd;
+    m_ownsFd = true;
+    m_failed = false;
+    return true;
+}
+
+void OutputSink::attach(int fd)
+{
+    close();
+
+    m_fd = fd;
+    m_ownsFd = false;
+    m_failed = false;
+}
+
+bool OutputSink::close()
+{
+    if (m_fd < 0) {
+        return !m_failed;
+    }
+
+    writeOut();
+    if (m_ownsFd && ::close(m_fd) != 0) {
+        m_failed = true;
+    }
+
+    m_fd = -1;
+    return !m_failed;
+}
+
+bool OutputSink::writeOut()
+{
+    const char* pos = pbase();
+    const char* end = pptr();
+    while (pos != end && !m_failed) {
+        ssize_t n = ::write(m_fd, pos, end - pos);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            m_failed = true;
+        }
+        else {
+            pos += n;
+        }
+    }
+
+    // after an error the output is dropped, close() reports it
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    return !m_failed;
+}
+
+OutputSink::int_type OutputSink::overflow(int_type c)
+{
+    if (m_fd < 0 || !writeOut()) {
+        return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize OutputSink::xsputn(const char* s, std::streamsize n)
+{
+    std::streamsize done = 0;
+    while (done < n) {
+        if (pptr() == epptr() && overflow(traits_type::eof()) == traits_type::eof()) {
+            break;
+        }
+
+        std::streamsize chunk = std::min<std::streamsize>(n - done, epptr() - pptr());
+        std::memcpy(pptr(), s + done, chunk);
+        pbump(chunk);
+        done += chunk;
+    }
+    return done;
+}
+
+int OutputSink::sync()
+{
+    // called for every table, see above
+    if (m_fd < 0 || std::size_t(pptr() - pbase()) < m_flushSize) {
+        return 0;
+    }
+    return writeOut() ? 0 : -1;
+}
@@ -0,0 +1,63 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <streambuf>
+#include <vector>
+
+// A stream buffer which writes to a file descriptor in large chunks, so
+// a document can be written as it is generated instead of being collected
+// in memory first. generateXdf() flushes its stream after every table; the
+// sink writes only once at least flushSize bytes are pending then, so the
+// output begins early without one write per table. The memory it uses
+// does not depend on the size of the output.
+class OutputSink : public std::streambuf
+{
+public:
+    explicit OutputSink(std::size_t capacity = 1 << 20, std::size_t flushSize = 64 << 10);
+    ~OutputSink();
+
+    // creates or truncates path
+    bool open(const char* path);
+
+    // writes to fd, which is not closed, e.g. STDOUT_FILENO
+    void attach(int fd);
+
+    // writes the rest, false if anything could not be written
+    bool close();
+
+    bool failed() const { return m_failed; }
+
+protected:
+    int_type overflow(int_type c);
+    std::streamsize xsputn(const char* s, std::streamsize n);
+    int sync();
+
+private:
+    // noncopyable
+    OutputSink(const OutputSink&);
+    OutputSink& operator=(const OutputSink&);
+
+    bool writeOut();
+
+    std::vector<char> m_buffer;
+    std::size_t m_flushSize;
+    int m_fd;
+    bool m_ownsFd;
+    bool m_failed;
+};
@@ -17,8 +17,9 @@
 #pragma once
 
 #include <boost/assert.hpp>
-#include <boost/checked_delete.hpp>
 
+// Links a child node to its parent. The pointee is owned by the Arena of
+// the tree and is released together with it, so owner_ptr never deletes.
 template<class T, class P, bool optional = false>
 class owner_ptr;
 
@@ -41,11 +42,6 @@ public:
         p->setParent(parent);
     }
 
-    ~owner_ptr()
-    {
-        boost::checked_delete(m_p);
-    }
-
     T & operator*() const // never throws
     {
         return *m_p;
@@ -91,11 +87,6 @@ public:
             p->setParent(parent);
     }
 
-    ~owner_ptr()
-    {
-        boost::checked_delete(m_p);
-    }
-
     T & operator*() const // never throws
     {
         BOOST_ASSERT( m_p != 0 );
@@ -0,0 +1,362 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <string>
+
+#include <boost/foreach.hpp>
+
+#include "node.h"
+#include "parser.hpp"
+#include "inputBuffer.h"
+#include "blockIndex.h"
+#include "parse.h"
+#include "linker.h"
+
+ParseContext::ParseContext(Arena& arena, LexerBackend backend, ParseEntry entry, DescriptorPool* descriptors) :
+    arena(arena),
+    lexer(backend),
+    startToken(entry == ProjectEntry ? TSTART_PROJECT : TSTART_STATEMENTS),
+    project(NULL),
+    block(NULL),
+    handler(NULL),
+    statementMark(arena.mark()),
+    ownDescriptors(arena),
+    descriptors(descriptors != NULL ? descriptors : &ownDescriptors)
+{ }
+
+void ParseContext::handleStatement(NStatement* statement)
+{
+    if (statement == NULL || !handler->statement(*statement)) {
+        arena.rewind(statementMark);
+        descriptors->clear(); // may refer to the released memory
+    }
+
+    statementMark = arena.mark();
+}
+
+int yylex(YYSTYPE* value, ParseContext* context)
+{
+    if (context->startToken != 0) {
+        int token = context->startToken;
+        context->startToken = 0;
+        return token;
+    }
+
+    return context->lexer.lex(value);
+}
+
+static NProject* parseProject(const char* begin, const char* end, Arena& arena, LexerBackend backend)
+{
+    ParseContext context(arena, backend, ProjectEntry);
+    context.lexer.reset(begin, end);
+
+    if (yyparse(&context) != 0) {
+        return NULL;
+    }
+
+    return context.project;
+}
+
+NProject* parseProject(const InputBuffer& input, Arena& arena, LexerBackend backend)
+{
+    NProject* project = parseProject(input.begin(), input.end(), arena, backend);
+    if (project != NULL) {
+        linkModule(project->m_module.ref());
+    }
+    return project;
+}
+
+NProject* parseProjectStreaming(const InputBuffer& input, Arena& arena, LexerBackend backend, StatementHandler& handler)
+{
+    ParseContext context(arena, backend, ProjectEntry);
+    context.handler = &handler;
+    context.lexer.reset(input.begin(), input.end());
+
+    if (yyparse(&context) != 0) {
+        return NULL;
+    }
+
+    return context.project;
+}
+
+NBlock* parseStatements(const char* begin, const char* end, int line, Arena& arena, LexerBackend backend,
+                        DescriptorPool* descriptors)
+{
+    ParseContext context(arena, backend, StatementsEntry, descriptors);
+    context.lexer.reset(begin, end, line);
+
+    if (yyparse(&context) != 0) {
+        return NULL;
+    }
+
+    return context.block;
+}
+
+NProject* parseSkeleton(const InputBuffer& input, const BlockIndex& index, Arena& arena, LexerBackend backend)
+{
+    std::string skeleton(input.begin(), index.statementsBegin());
+    skeleton += '\n';
+    skeleton.append(index.statementsEnd(), input.end());
+    StringRef text = arena.copy(skeleton.data(), skeleton.size());
+
+    return parseProject(text.data, text.data + text.length, arena, backend);
+}
+
+namespace {
+
+// a run of consecutive MODULE statements, parsed by one worker
+struct Chunk
+{
+    const char* begin;
+    const char* end;
+    int line;
+    NBlock* block;
+};
+
+struct ChunkQueue
+{
+    std::vector<Chunk> chunks;
+    LexerBackend backend;
+    SymbolTable* names; // of the calling thread
+    std::atomic<std::size_t> next;
+    std::atomic<bool> failed;
+};
+
+// Each worker has an arena of its own, so the allocations need no locking.
+void parseChunks(ChunkQueue* queue, Arena* arena)
+{
+    SymbolScope scope(*queue->names);
+    DescriptorPool descriptors(*arena);
+
+    for (;;) {
+        std::size_t i = queue->next.fetch_add(1);
+        if (i >= queue->chunks.size() || queue->failed) {
+            return;
+        }
+
+        Chunk& chunk = queue->chunks[i];
+        chunk.block = parseStatements(chunk.begin, chunk.end, chunk.line, *arena, queue->backend, &descriptors);
+        if (chunk.block == NULL) {
+            queue->failed = true;
+            return;
+        }
+    }
+}
+
+} // namespace
+
+NProject* parseProjectParallel(const InputBuffer& input, Arena& arena, LexerBackend backend, unsigned threads)
+{
+    const std::size_t ChunksPerThread = 8; // smooths out uneven chunks
+    const std::size_t MinBlocksPerChunk = 16;
+
+    BlockIndex index;
+    if (threads < 2 || !index.build(input.begin(), input.end())) {
+        return parseProject(input, arena, backend);
+    }
+
+    const std::vector<BlockIndex::Block>& blocks = index.statements();
+    std::size_t chunkCount = std::min<std::size_t>(threads * ChunksPerThread, blocks.size() / MinBlocksPerChunk);
+    if (chunkCount < 2) {
+        return parseProject(input, arena, backend);
+    }
+
+    // split the statements into chunks of about the same size in bytes
+    ChunkQueue queue;
+    queue.backend = backend;
+    queue.names = &symbols();
+    queue.next = 0;
+    queue.failed = false;
+
+    std::size_t chunkSize = (index.statementsEnd() - blocks.front().begin) / chunkCount;
+    BOOST_FOREACH(const BlockIndex::Block& block, blocks) {
+        if (queue.chunks.empty() || std::size_t(block.begin - queue.chunks.back().begin) >= chunkSize) {
+            if (!queue.chunks.empty()) queue.chunks.back().end = block.begin;
+            Chunk chunk = { block.begin, NULL, block.line, NULL };
+            queue.chunks.push_back(chunk);
+        }
+    }
+    queue.chunks.back().end = index.statementsEnd();
+
+    unsigned workerCount = std::min<std::size_t>(threads, queue.chunks.size());
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < workerCount; ++i) {
+        Arena* workerArena = arena.create<Arena>();
+        arena.addFinalizer(workerArena);
+        workers.push_back(std::thread(parseChunks, &queue, workerArena));
+    }
+
+    // the rest of the file, with an empty MODULE body, is parsed meanwhile
+    NProject* project = parseSkeleton(input, index, arena, backend);
+
+    BOOST_FOREACH(std::thread& worker, workers) {
+        worker.join();
+    }
+
+    if (project == NULL || queue.failed) {
+        return NULL;
+    }
+
+    // keeps the order of the input
+    BOOST_FOREACH(const Chunk& chunk, queue.chunks) {
+        project->m_module->addStatements(chunk.block->statements);
+    }
+
+    linkModule(project->m_module.ref(), threads);
+    return project;
+}
+
+namespace {
+
+bool objectKind(std::string_view keyword, ObjectKind& kind)
+{
+    if (keyword == "CHARACTERISTIC")    kind = CharacteristicObject;
+    else if (keyword == "MEASUREMENT")  kind = MeasurementObject;
+    else if (keyword == "AXIS_PTS")     kind = AxisPtsObject;
+    else if (keyword == "COMPU_METHOD") kind = CompuMethodObject;
+    else if (keyword == "RECORD_LAYOUT") kind = RecordLayoutObject;
+    else if (keyword == "FUNCTION")     kind = FunctionObject;
+    else return false;
+
+    return true;
+}
+
+// Knows where each object of the module is in the input and parses it on
+// its first lookup. Loaded objects are marked, so none is parsed twice.
+class LazyLoader : public ObjectLoader
+{
+public:
+    LazyLoader(NModule& module, Arena& arena, LexerBackend backend) :
+        m_module(module),
+        m_arena(arena),
+        m_backend(backend),
+        m_descriptors(arena)
+    { }
+
+    void add(const BlockIndex::Block& block)
+    {
+        ObjectKind kind;
+        if (!objectKind(block.keyword, kind)) {
+            return;
+        }
+
+        // the last one wins at the place of the first, like in the maps
+        std::vector<Entry>& entries = m_entries[kind];
+        std::pair<NameMap::iterator, bool> i = m_names[kind].insert(NameMap::value_type(block.name, entries.size()));
+        Entry entry = { block, false };
+        if (i.second) {
+            entries.push_back(entry);
+        }
+        else {
+            entries[i.first->second] = entry;
+        }
+    }
+
+    bool load(ObjectKind kind, Symbol id)
+    {
+        NameMap::const_iterator i = m_names[kind].find(symbols().name(id));
+        if (i == m_names[kind].end()) {
+            return false;
+        }
+
+        return load(m_entries[kind][i->second]);
+    }
+
+    // in input order, so the maps are filled like by a complete parse
+    bool loadAll(ObjectKind kind)
+    {
+        bool result = true;
+        BOOST_FOREACH(Entry& entry, m_entries[kind]) {
+            if (!entry.loaded) {
+                result = load(entry) && result;
+            }
+        }
+        return result;
+    }
+
+private:
+    struct Entry
+    {
+        BlockIndex::Block block;
+        bool loaded;
+    };
+
+    // the entry of each name
+    typedef boost::unordered_map<std::string_view, std::size_t, std::hash<std::string_view> > NameMap;
+
+    bool load(Entry& entry)
+    {
+        if (entry.loaded) {
+            return false;
+        }
+
+        entry.loaded = true; // also if it fails, it is not parsed twice
+        return parse(entry.block);
+    }
+
+    bool parse(const BlockIndex::Block& block)
+    {
+        NBlock* statements = parseStatements(block.begin, block.end, block.line, m_arena, m_backend, &m_descriptors);
+        if (statements == NULL) {
+            return false;
+        }
+
+        m_module.addStatements(statements->statements);
+        return true;
+    }
+
+    NModule& m_module;
+    Arena& m_arena;
+    LexerBackend m_backend;
+    DescriptorPool m_descriptors; // shared by all the loads
+    std::vector<Entry> m_entries[FunctionObject + 1]; // in input order
+    NameMap m_names[FunctionObject + 1];
+};
+
+} // namespace
+
+NProject* parseProjectLazy(const InputBuffer& input, Arena& arena, LexerBackend backend)
+{
+    BlockIndex index;
+    if (!index.build(input.begin(), input.end())) {
+        return parseProject(input, arena, backend);
+    }
+
+    NProject* project = parseSkeleton(input, index, arena, backend);
+    if (project == NULL) {
+        return NULL;
+    }
+
+    NModule& module = project->m_module.ref();
+    LazyLoader* loader = arena.create<LazyLoader>(module, arena, backend);
+    arena.addFinalizer(loader);
+
+    BOOST_FOREACH(const BlockIndex::Block& block, index.statements()) {
+        loader->add(block);
+    }
+
+    // the generators walk all functions to find the categories
+    if (!loader->loadAll(FunctionObject)) {
+        return NULL;
+    }
+
+    module.setLoader(loader);
+    return project;
+}
@@ -0,0 +1,109 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "arena.h"
+#include "lexer.h"
+#include "descriptorPool.h"
+
+class InputBuffer;
+class BlockIndex;
+class NProject;
+class NBlock;
+class NStatement;
+union YYSTYPE;
+
+// what a parse expects to find in its input
+enum ParseEntry
+{
+    ProjectEntry,   // a complete A2L file
+    StatementsEntry // a sequence of the statements of a MODULE
+};
+
+// Receives the objects of a MODULE one by one while they are parsed, see
+// parseProjectStreaming().
+class StatementHandler
+{
+public:
+    virtual ~StatementHandler() { }
+
+    // Called as soon as statement is complete. Returning false drops it:
+    // its memory is reused for the next statement. Objects which are kept
+    // stay valid as long as the arena.
+    virtual bool statement(NStatement& statement) = 0;
+};
+
+// The state of one run of the (pure) bison parser. Nodes are allocated in
+// arena, the result is stored in project or block depending on the entry.
+struct ParseContext
+{
+    ParseContext(Arena& arena, LexerBackend backend, ParseEntry entry, DescriptorPool* descriptors = NULL);
+
+    Arena& arena;
+    Lexer lexer;
+    int startToken; // handed to the parser before the first real token
+
+    NProject* project;
+    NBlock* block;
+
+    // NULL if the statements are collected in block
+    StatementHandler* handler;
+    Arena::Mark statementMark; // where the current statement begins
+
+    // shares the axes and record layout members, ownDescriptors unless
+    // the caller keeps a pool over several parses into the same arena
+    DescriptorPool ownDescriptors;
+    DescriptorPool* descriptors;
+
+    // called by the grammar actions
+    void beginStatements() { statementMark = arena.mark(); }
+    void handleStatement(NStatement* statement);
+};
+
+// called by yyparse()
+int yylex(YYSTYPE* value, ParseContext* context);
+
+// Parses a complete A2L file and links its module, see linkModule(). Returns
+// NULL on errors, which are reported on stdout. All nodes are allocated in
+// arena, the tokens may refer to input.
+NProject* parseProject(const InputBuffer& input, Arena& arena, LexerBackend backend);
+
+// Parses a part of a MODULE body; line is the line number of begin. Returns
+// NULL on errors. descriptors, if given, must allocate in arena.
+NBlock* parseStatements(const char* begin, const char* end, int line, Arena& arena, LexerBackend backend,
+                        DescriptorPool* descriptors = NULL);
+
+// Parses input without the statements of its MODULE, which index locates.
+NProject* parseSkeleton(const InputBuffer& input, const BlockIndex& index, Arena& arena, LexerBackend backend);
+
+// Like parseProject, but the statements of the MODULE are split into chunks
+// at their /begin-/end boundaries and parsed by up to threads threads. Falls
+// back to a sequential parse if the input is too small or its structure can
+// not be indexed.
+NProject* parseProjectParallel(const InputBuffer& input, Arena& arena, LexerBackend backend, unsigned threads);
+
+// Parses only the structure of the file. The objects of the MODULE are
+// parsed when NModule looks them up for the first time, so the work depends
+// on the objects used, not on the size of the file. The functions are the
+// exception, they are parsed right away. input has to outlive the project.
+NProject* parseProjectLazy(const InputBuffer& input, Arena& arena, LexerBackend backend);
+
+// Parses the file without building the body of the MODULE: handler gets
+// each object as soon as it is parsed. The memory needed is bounded by the
+// largest object plus the objects the handler keeps. The maps of the
+// returned module are empty.
+NProject* parseProjectStreaming(const InputBuffer& input, Arena& arena, LexerBackend backend, StatementHandler& handler);
@@ -14,21 +14,26 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+%code requires {
+	struct ParseContext;
+}
+
 %{
 	#include <cstdio>
-//	#include <stack>
-	#include "stack.hpp"
 	#include "node.h"
 	#include "util.h"
+	#include "lexer.h"
+	#include "parse.h"
 
-	NProject* projectBlock; /* the top level root node of our final AST */
-	extern int yylineno; // TO/DO
-	extern int yylex();
-	void yyerror(const char *s) { printf("Error at line %d: %s\n", yylineno, s); }
-
-ext::stack<Node *> nodes;
+	void yyerror(ParseContext* context, const char *s) { fprintf(stderr, "Error at line %d: %s\n", context->lexer.lineNo(), s); }
 %}
 
+/* The parser keeps no global state, so several parses can run at once.
+   Everything a parse needs and produces lives in the ParseContext. */
+%define api.pure full
+%parse-param { ParseContext* context }
+%lex-param { ParseContext* context }
+
 /* Represents the many different ways we can access our data */
 %union {
 	Node *node;
@@ -39,7 +44,7 @@ ext::stack<Node *> nodes;
 //	NVariableDeclaration *var_decl;
 //	std::vector<NVariableDeclaration*> *varvec;
 NCharacteristic *characteristic;
-NFormat *format;
+Format format;
 NAxis *axis;
 NNumeric *numeric;
 NAddress *address;
@@ -49,10 +54,15 @@ NHeader* header;
 NModule* module;
 NRecordLayout::FncValues* fncValues;
 
-	std::vector<NExpression*> *exprvec;
-	std::vector<NStatement*> *stmtvec;
+	ExpressionList *exprvec;
+	StatementList *stmtvec;
+	SymbolList *symbolvec;
 
-	std::string *string;
+	StringRef string;
+	Symbol symbol;
+	long long integer;
+	double number;
+	unsigned long addressValue;
 	int token;
 
 	int value;
@@ -62,7 +72,10 @@ NRecordLayout::FncValues* fncValues;
    match our tokens.l lex file. We also define the node type
    they represent.
  */
-%token <string> TADDRESS TSTRING TIDENTIFIER TDOUBLE TINTEGER
+%token <string> TSTRING TIDENTIFIER
+%token <integer> TINTEGER
+%token <number> TDOUBLE
+%token <addressValue> TADDRESS
 %token <token> TLBRACE TRBRACE
 %token <token> TUWORD TSWORD TUBYTE TSBYTE TULONG TSLONG TFLOAT32
 %token <token> TABSOLUTE TAXIS_DESCR TAXIS_PTS TCHARACTERISTIC TCOMPU_METHOD TCOM_AXIS TCURVE TDEF_CHARACTERISTIC TDEPOSIT TFORMAT TFUNCTION TSTD_AXIS  TMAP TMODULE TPROJECT TVALUE TVAL_BLK TMEASUREMENT TREF_CHARACTERISTIC TIN_MEASUREMENT TOUT_MEASUREMENT TLOC_MEASUREMENT TSUB_FUNCTION TMOD_COMMON TMOD_PAR TBYTE_ORDER TMSB_LAST TALIGNMENT_BYTE TALIGNMENT_WORD TALIGNMENT_LONG TMEMORY_SEGMENT TCODE TEPROM TEXTERN TINTERN TSYSTEM_CONSTANT TECU_ADDRESS TBIT_MASK TAXIS_PTS_REF TFIX_AXIS TFIX_AXIS_PAR TB_TRUE TARRAY_SIZE TREAD_ONLY TNUMBER TRAT_FUNC TCOEFFS TCOMPU_TAB TTAB_INTP TASCII TTAB_VERB TCOMPU_TAB_REF TCOMPU_VTAB TASAP2_VERSION THEADER TVERSION TPROJECT_NO
@@ -70,6 +83,12 @@ NRecordLayout::FncValues* fncValues;
 // record_layout tokens:
 %token <token> TRECORD_LAYOUT TNO_AXIS_PTS_X TNO_AXIS_PTS_Y TAXIS_PTS_X TAXIS_PTS_Y TINDEX_INCR TFNC_VALUES TCOLUMN_DIR TDIRECT
 
+// never produced by a scanner, yylex() returns one of them first to select what to parse
+%token TSTART_PROJECT TSTART_STATEMENTS
+
+// a malformed number, see convertNumber(); no rule accepts it, so it is a syntax error
+%token TINVALID
+
 /* Define the type of node our nonterminal symbols represent.
    The types refer to the %union declaration above. Ex: when
    we call an ident (defined by union type ident) we are really
@@ -77,6 +96,7 @@ NRecordLayout::FncValues* fncValues;
  */
 %type <stmt> stmt characteristic axis_pts measurement function record_layout compu_method compu_tab compu_vtab memory_segment mod_par system_constant mod_common
 %type <ident> ident
+%type <symbol> name
 %type <block>  stmts //project
 %type <format> format format_optional
 
@@ -89,26 +109,32 @@ NRecordLayout::FncValues* fncValues;
 %type <token> type
 %type <axis> axis_desc std_axis com_axis fix_axis
 %type <numeric> numeric
+%type <number> number
 %type <address> address
 
 %type <value> number_tag
 %type <flag> access
-%type <exprvec> ident_list numeric_list def_characteristic ref_characteristic in_measurement out_measurement loc_measurement sub_function
+%type <exprvec> numeric_list
+%type <symbolvec> name_list def_characteristic ref_characteristic in_measurement out_measurement loc_measurement sub_function
 %type <stmtvec> system_constant_list var_defs
 
-%type <string> bit_mask
+%type <addressValue> bit_mask
 
-%start project
+%start start
 
 %%
 
+start :	TSTART_PROJECT project
+	| TSTART_STATEMENTS stmts { context->block = $2; } // a slice of the module body
+	;
+
 // main block
 project :	TASAP2_VERSION numeric numeric
 		TLBRACE TPROJECT ident string
 			header
 			module
 		TRBRACE TPROJECT
-		{ projectBlock = new NProject($8, $9); YYACCEPT; }
+		{ context->project = new (context->arena) NProject($8, $9); YYACCEPT; }
 	;
 
 header :	TLBRACE THEADER TSTRING
@@ -116,7 +142,7 @@ header :	TLBRACE THEADER TSTRING
 			TPROJECT_NO ident
 		TRBRACE THEADER
 		{
-			$$ = new NHeader(*$3, *$5, $7);
+			$$ = new (context->arena) NHeader(context->arena.copy($3), context->arena.copy($5), $7);
 		}
 	;
 
@@ -126,12 +152,17 @@ module :	TLBRACE TMODULE ident string
 			stmts
 		TRBRACE TMODULE
 		{
-			$$ = new NModule($7);
+			$$ = new (context->arena) NModule($7);
+			context->arena.addFinalizer($$); // the maps are not arena allocated
 		}
 	;
 
-stmts : stmt { $$ = new NBlock(); $$->statements.push_back($<stmt>1); }
-	| stmts stmt { $1->statements.push_back($<stmt>2); }
+stmts : /* empty */ { $$ = new (context->arena) NBlock(context->arena); context->beginStatements(); }
+	| stmts stmt
+	{
+		if (context->handler != NULL) context->handleStatement($2); // streaming, the block stays empty
+		else $1->statements.push_back($2);
+	}
 	;
 
 stmt : characteristic
@@ -149,72 +180,69 @@ expr :	  ident { $<ident>$ = $1; }
 	| string
 	;
 
-ident_list : /* empty */ { $$ = new ExpressionList(); } | ident_list ident { $1->push_back($2); }
+name_list : /* empty */ { $$ = context->arena.create<SymbolList>(context->arena); } | name_list name { $1->push_back($2); }
+	;
+
+ident : name { $$ = new (context->arena) NIdentifier($1); }
 	;
 
-ident : TIDENTIFIER { $$ = new NIdentifier(*$1); }
-	| TVERSION { $$ = new NIdentifier("VERSION"); } // workaround
+// names and references of objects are stored as plain symbols
+name : TIDENTIFIER { $$ = symbols().intern($1.data, $1.length); }
+	| TVERSION { $$ = symbols().intern("VERSION"); } // workaround
 	;
 
-system_constant_list : /* empty */ { $$ = new StatementList(); } | system_constant_list system_constant { $1->push_back($2); }
+system_constant_list : /* empty */ { $$ = context->arena.create<StatementList>(context->arena); } | system_constant_list system_constant { $1->push_back($2); }
 	;
 
 system_constant : TSYSTEM_CONSTANT TSTRING TSTRING
 	{
-		NExpression* expr = new NInteger(atol($3->c_str())); // should always be an integer
-		NIdentifier* ident = new NIdentifier(*$2);
-		$$ = new NConstant(ident, *expr);
+		NExpression* expr = new (context->arena) NInteger(toLong($3)); // should always be an integer
+		$$ = new (context->arena) NConstant(symbols().intern($2.data, $2.length), *expr);
 	}
 	;
 
-var_defs :  /* empty */ { $$ = new StatementList(); } | var_defs var_def { $1->push_back($2); }
+var_defs :  /* empty */ { $$ = context->arena.create<StatementList>(context->arena); } | var_defs var_def { $1->push_back($2); }
 	;
 
-var_def : ident expr { $$ = new NVariable($1); $$->assignmentExpr = $2; }
+var_def : name expr { $$ = new (context->arena) NVariable($1); $$->assignmentExpr = $2; }
 	;
 
-numeric_list : /* empty */ { $$ = new ExpressionList(); } | numeric_list numeric { $1->push_back($2); }
+numeric_list : /* empty */ { $$ = context->arena.create<ExpressionList>(context->arena); } | numeric_list numeric { $1->push_back($2); }
 	;
 
-numeric : TINTEGER { $$ = new NInteger(atol($1->c_str())); }
-	| TDOUBLE { $$ = new NDouble(atof($1->c_str())); }
-	| address { $$ = $1 }
+numeric : TINTEGER { $$ = new (context->arena) NInteger($1); }
+	| TDOUBLE { $$ = new (context->arena) NDouble($1); }
+	| address { $$ = $1; }
 	;
 
-address: TADDRESS
-	{
-		std::string addr = getAddressSubstr(*$1); // remove leading '"0x' and rear '"' characters
-		char* p;
-		unsigned long n = strtoul(addr.c_str(), &p, 16); // addresses are hexadecimal
-		if (*p != 0) {  
-			printf("Invalid address at line %d\n", yylineno);
-			YYERROR;
-		}
+address: TADDRESS { $$ = new (context->arena) NAddress($1); } // converted by the lexer
+	;
 
-		$$ = new NAddress(n);
-	}
+number : TINTEGER { $$ = $1; }
+	| TDOUBLE { $$ = $1; }
+	| TADDRESS { $$ = $1; }
 	;
 
-string : TSTRING { $$ = new NStringLiteral(*$1); }
+string : TSTRING { $$ = new (context->arena) NStringLiteral(context->arena.copy($1)); }
 	;
 
 type : TUWORD | TSWORD | TUBYTE | TSBYTE | TULONG | TSLONG | TFLOAT32
 	;
 
-access : /* empty */ { $$ = true } | TREAD_ONLY { printf("\tREAD_ONLY mark\n"); $$ = false; }
+access : /* empty */ { $$ = true; } | TREAD_ONLY { fprintf(stderr, "\tREAD_ONLY mark\n"); $$ = false; }
 	;
 
-number_tag : /* empty */ { $$ = 0 } | TNUMBER TINTEGER { $$ = atoi($2->c_str()); }
+number_tag : /* empty */ { $$ = 0; } | TNUMBER TINTEGER { $$ = $2; }
 	;
 
 memory_segment : TLBRACE TMEMORY_SEGMENT
-			ident
+			name
 			TSTRING
-			ident_list
+			name_list
 			numeric_list
 		TRBRACE TMEMORY_SEGMENT
 		{
-			printf("\tmemory-segment\n");
+			fprintf(stderr, "\tmemory-segment\n");
 			$$ = NULL; // TODO
 		}
 	;
@@ -230,7 +258,7 @@ mod_par :	TLBRACE TMOD_PAR TSTRING
 			system_constant_list
 		TRBRACE TMOD_PAR
 		{
-			printf("\tmod_par\n");
+			fprintf(stderr, "\tmod_par\n");
 			$$ = NULL;
 		}
 	;
@@ -242,37 +270,37 @@ mod_common :	TLBRACE TMOD_COMMON TSTRING
 			TALIGNMENT_LONG TINTEGER
 		TRBRACE TMOD_COMMON
 		{
-			printf("\tmod_common\n");
+			fprintf(stderr, "\tmod_common\n");
 			$$ = NULL;
 		}
 	;
 
 characteristic : TLBRACE TCHARACTERISTIC // com-axis
-			ident
+			name
 			TSTRING // description std::string
 			TMAP
-			address //TADDRESS
-			ident
-			TDOUBLE // scale std::string to double
-			ident
-			TDOUBLE // min std::string to double
-			TDOUBLE // max std::string to double
+			TADDRESS
+			name
+			TDOUBLE // scale
+			name
+			TDOUBLE // min
+			TDOUBLE // max
 			format
 			access
 			axis_desc //com_axis //axis_desc
 			axis_desc //com_axis //axis_desc
 		TRBRACE TCHARACTERISTIC
 		{
-			printf ("\tcharacteristic-map: %s\n", $3->name.c_str());
+			fprintf(stderr, "\tcharacteristic-map: %s\n", symbols().name($3).c_str());
 
-			$$ = createMap($3 /* name */,
-					*$4 /* description */,
+			$$ = createMap(context->arena, $3 /* name */,
+					context->arena.copy($4) /* description */,
 					$6 /* address */,
 					$7 /* recordLayout */,
-					atof($8->c_str()) /* scale */,
+					$8 /* scale */,
 					$9 /* compuMethod */,
-					atof($10->c_str()) /* min */,
-					atof($11->c_str()) /* max */,
+					$10 /* min */,
+					$11 /* max */,
 					$12 /* format */,
 					$14 /* axis_1 */,
 					$15 /* axis_2 */);
@@ -280,168 +308,168 @@ characteristic : TLBRACE TCHARACTERISTIC // com-axis
 		}
 	|
 		TLBRACE TCHARACTERISTIC
-			ident
+			name
 			TSTRING // description std::string
 			TCURVE
-			address //TADDRESS
-			ident
-			TDOUBLE // scale std::string to double
-			ident
-			TDOUBLE // min std::string to double
-			TDOUBLE // max std::string to double
+			TADDRESS
+			name
+			TDOUBLE // scale
+			name
+			TDOUBLE // min
+			TDOUBLE // max
 			format
 			access
 			axis_desc
 		TRBRACE TCHARACTERISTIC
 		{
-			printf ("\tcharacteristic-curve: %s\n", $3->name.c_str());
+			fprintf(stderr, "\tcharacteristic-curve: %s\n", symbols().name($3).c_str());
 
-			$$ = new NCurve($3 /* name */,
-					*$4 /* description */,
+			$$ = new (context->arena) NCurve($3 /* name */,
+					context->arena.copy($4) /* description */,
 					$6 /* address */,
 					$7 /* recordLayout */,
-					atof($8->c_str()) /* scale */,
+					$8 /* scale */,
 					$9 /* compuMethod */,
-					atof($10->c_str()) /* min */,
-					atof($11->c_str()) /* max */,
+					$10 /* min */,
+					$11 /* max */,
 					$12 /* format */,
 					$14 /* axis_1 */);
 		}
 	|
 		TLBRACE TCHARACTERISTIC
-			ident
+			name
 			TSTRING // description std::string
 			TVALUE
-			address //TADDRESS
-			ident
-			TDOUBLE // scale std::string to double
-			ident
-			TDOUBLE // min std::string to double
-			TDOUBLE // max std::string to double
+			TADDRESS
+			name
+			TDOUBLE // scale
+			name
+			TDOUBLE // min
+			TDOUBLE // max
 			format
 			access
 		TRBRACE TCHARACTERISTIC
 		{
-			printf ("\tcharacteristic-value: %s %s\n", $3->name.c_str(), $4->c_str());
+			fprintf(stderr, "\tcharacteristic-value: %s %.*s\n", symbols().name($3).c_str(), (int) $4.length, $4.data);
 
-			$$ = new NValue($3 /* name */,
-					*$4 /* description */,
+			$$ = new (context->arena) NValue($3 /* name */,
+					context->arena.copy($4) /* description */,
 					$6 /* address */,
 					$7 /* recordLayout */,
-					atof($8->c_str()) /* scale */,
+					$8 /* scale */,
 					$9 /* compuMethod */,
-					atof($10->c_str()) /* min */,
-					atof($11->c_str()) /* max */,
+					$10 /* min */,
+					$11 /* max */,
 					$12 /* format */);
 		}
 	|
 		TLBRACE TCHARACTERISTIC
-			ident
+			name
 			TSTRING // description std::string
 			TVAL_BLK
-			address //TADDRESS
-			ident
-			TDOUBLE // scale std::string to double
-			ident
-			TDOUBLE // min std::string to double
-			TDOUBLE // max std::string to double
+			TADDRESS
+			name
+			TDOUBLE // scale
+			name
+			TDOUBLE // min
+			TDOUBLE // max
 			format
 			access
 			number_tag
 		TRBRACE TCHARACTERISTIC
 		{
-			printf ("\tcharacteristic-valblk: %s number: %d\n", $3->name.c_str(), $14);
+			fprintf(stderr, "\tcharacteristic-valblk: %s number: %d\n", symbols().name($3).c_str(), $14);
 
-			$$ = new NValBlk($3 /* name */,
-					*$4 /* description */,
+			$$ = new (context->arena) NValBlk($3 /* name */,
+					context->arena.copy($4) /* description */,
 					$6 /* address */,
 					$7 /* recordLayout */,
-					atof($8->c_str()) /* scale */,
+					$8 /* scale */,
 					$9 /* compuMethod */,
-					atof($10->c_str()) /* min */,
-					atof($11->c_str()) /* max */,
+					$10 /* min */,
+					$11 /* max */,
 					$12 /* format */,
 					$14);	// number
 		}
 	|
 		TLBRACE TCHARACTERISTIC
-			ident
+			name
 			TSTRING // description std::string
 			TASCII
-			address //TADDRESS
-			ident
-			TDOUBLE // scale std::string to double
-			ident
-			TDOUBLE // min std::string to double
-			TDOUBLE // max std::string to double
+			TADDRESS
+			name
+			TDOUBLE // scale
+			name
+			TDOUBLE // min
+			TDOUBLE // max
 			format_optional
 			access
 			number_tag
 		TRBRACE TCHARACTERISTIC
 		{
-			printf ("\tcharacteristic-ascii: %s number: %d\n", $3->name.c_str(), $14);
+			fprintf(stderr, "\tcharacteristic-ascii: %s number: %d\n", symbols().name($3).c_str(), $14);
 
-			$$ = new NCharacteristicText($3 /* name */,
-					*$4 /* description */,
+			$$ = new (context->arena) NCharacteristicText($3 /* name */,
+					context->arena.copy($4) /* description */,
 					$6 /* address */,
 					$7 /* recordLayout */,
-					atof($8->c_str()) /* scale */,
+					$8 /* scale */,
 					$9 /* compuMethod */,
-					atof($10->c_str()) /* min */,
-					atof($11->c_str()) /* max */,
+					$10 /* min */,
+					$11 /* max */,
 					$12 /* format */,
 					$14);	// number
 		}
 	; // characteristic
 
 measurement :	TLBRACE TMEASUREMENT
-			ident
+			name
 			TSTRING // description std::string
 			type		// datatype
 			TB_TRUE
-			TINTEGER // int1 std::string to int
-			TINTEGER // int2 std::string to int
-			numeric		// min; double or int
-			numeric		// max; double or int
-			bit_mask	// bitMask std::string*
+			TINTEGER // int1
+			TINTEGER // int2
+			number		// min; double or int
+			number		// max; double or int
+			bit_mask	// bitMask
 			format
-			TECU_ADDRESS address //TADDRESS
+			TECU_ADDRESS TADDRESS
 		TRBRACE TMEASUREMENT
 		{
-			printf ("\tmeasurement-bit: %s\n", $3->name.c_str());
+			fprintf(stderr, "\tmeasurement-bit: %s\n", symbols().name($3).c_str());
 
-			$$ = new NMeasurementBit($3,	// name
-						*$4,	// description
+			$$ = new (context->arena) NMeasurementBit($3,	// name
+						context->arena.copy($4),	// description
 						$5,	// dataType
-						atoi($7->c_str()), // int1
-						atoi($8->c_str()), // int2
+						$7, // int1
+						$8, // int2
 						$9,	// min
 						$10,	// max
 						$12,	// format
 						$14,	// address
-						*$11);	// bitMask
+						$11);	// bitMask
 		}
 	| // without bitmask
 		TLBRACE TMEASUREMENT
-			ident
+			name
 			TSTRING // description std::string
 			type		// datatype
-			ident		// samples: dez, t10msxs_ub_b2p55
-			TINTEGER // int1 std::string to int
-			TINTEGER // int2 std::string to int
-			numeric		// min; double or int
-			numeric		// max; double or int
+			name		// samples: dez, t10msxs_ub_b2p55
+			TINTEGER // int1
+			TINTEGER // int2
+			number		// min; double or int
+			number		// max; double or int
 			format
-			TECU_ADDRESS address //TADDRESS
+			TECU_ADDRESS TADDRESS
 		TRBRACE TMEASUREMENT
 		{
-			printf ("\tmeasurement-value: %s\n", $3->name.c_str());
+			fprintf(stderr, "\tmeasurement-value: %s\n", symbols().name($3).c_str());
 
-			$$ = new NMeasurementValue($3,	// name
-						*$4,	// description
+			$$ = new (context->arena) NMeasurementValue($3,	// name
+						context->arena.copy($4),	// description
 						$5,	// dataType
-						atoi($7->c_str()), // int1
-						atoi($8->c_str()), // int2
+						$7, // int1
+						$8, // int2
 						$9,	// min
 						$10,	// max
 						$11,	// format
@@ -450,26 +478,26 @@ measurement :	TLBRACE TMEASUREMENT
 		}
 	| // with bitmask
 		TLBRACE TMEASUREMENT
-			ident
+			name
 			TSTRING // description std::string
 			type		// datatype
-			ident		// samples: dez, t10msxs_ub_b2p55
-			TINTEGER // int1 std::string to int
-			TINTEGER // int2 std::string to int
-			numeric		// min; double or int
-			numeric		// max; double or int
-			bit_mask // std::string*
+			name		// samples: dez, t10msxs_ub_b2p55
+			TINTEGER // int1
+			TINTEGER // int2
+			number		// min; double or int
+			number		// max; double or int
+			bit_mask
 			format
-			TECU_ADDRESS address //TADDRESS
+			TECU_ADDRESS TADDRESS
 		TRBRACE TMEASUREMENT
 		{
-			printf ("\tmeasurement-value: %s\n", $3->name.c_str());
+			fprintf(stderr, "\tmeasurement-value: %s\n", symbols().name($3).c_str());
 
-			$$ = new NMeasurementValue($3,	// name
-						*$4,	// description
+			$$ = new (context->arena) NMeasurementValue($3,	// name
+						context->arena.copy($4),	// description
 						$5,	// dataType
-						atoi($7->c_str()), // int1
-						atoi($8->c_str()), // int2
+						$7, // int1
+						$8, // int2
 						$9,	// min
 						$10,	// max
 						$12,	// format
@@ -478,32 +506,32 @@ measurement :	TLBRACE TMEASUREMENT
 		}
 	|
 		TLBRACE TMEASUREMENT
-			ident
+			name
 			TSTRING // description std::string
 			type		// datatype
-			ident		// samples: dez, t10msxs_ub_b2p55
-			TINTEGER // int1 std::string to int
-			TINTEGER // int2 std::string to int
-			numeric		// min; double or int
-			numeric		// max; double or int
+			name		// samples: dez, t10msxs_ub_b2p55
+			TINTEGER // int1
+			TINTEGER // int2
+			number		// min; double or int
+			number		// max; double or int
 			format
-			TARRAY_SIZE TINTEGER // arraySize std::string to int
-			TECU_ADDRESS address //TADDRESS
+			TARRAY_SIZE TINTEGER // arraySize
+			TECU_ADDRESS TADDRESS
 		TRBRACE TMEASUREMENT
 		{
-			printf ("\tmeasurement-array: %s\n", $3->name.c_str());
+			fprintf(stderr, "\tmeasurement-array: %s\n", symbols().name($3).c_str());
 
-			$$ = new NMeasurementArray($3,	// name
-						*$4,	// description
+			$$ = new (context->arena) NMeasurementArray($3,	// name
+						context->arena.copy($4),	// description
 						$5,	// dataType
-						atoi($7->c_str()), // int1
-						atoi($8->c_str()), // int2
+						$7, // int1
+						$8, // int2
 						$9,	// min
 						$10,	// max
 						$11,	// format
 						$15,	// address
 						$6,	// type
-						atoi($13->c_str())); // arraySize
+						$13); // arraySize
 		}
 	; // measurement
 
@@ -514,8 +542,8 @@ axis_desc : std_axis { $$ = $1; }
 
 std_axis :	TLBRACE TAXIS_DESCR
 			TSTD_AXIS
-			ident
-			ident // compuMethod
+			name
+			name // compuMethod
 			TINTEGER
 			TDOUBLE
 			TDOUBLE
@@ -523,30 +551,30 @@ std_axis :	TLBRACE TAXIS_DESCR
 			deposit
 		TRBRACE TAXIS_DESCR
 		{
-			printf ("\tstd-axis\n");
-			$$ = new NStdAxis($4, $5, atol($6->c_str()), atof($7->c_str()), atof($8->c_str()), $9);
+			fprintf(stderr, "\tstd-axis\n");
+			$$ = context->descriptors->stdAxis($4, $5, $6, $7, $8, $9);
 		}
 	;
 
 com_axis :	TLBRACE TAXIS_DESCR
 			TCOM_AXIS
-			ident
-			ident // compuMethod
+			name
+			name // compuMethod
 			TINTEGER
 			TDOUBLE
 			TDOUBLE
-			TAXIS_PTS_REF ident
+			TAXIS_PTS_REF name
 		TRBRACE TAXIS_DESCR
 		{
-			printf ("\tcom-axis\n");
-			$$ = new NComAxis($4, $5, atol($6->c_str()), atof($7->c_str()), atof($8->c_str()), $10);
+			fprintf(stderr, "\tcom-axis\n");
+			$$ = context->descriptors->comAxis($4, $5, $6, $7, $8, $10);
 		}
 	;
 
 fix_axis :	TLBRACE TAXIS_DESCR
 			TFIX_AXIS
-			ident
-			ident // compuMethod
+			name
+			name // compuMethod
 			TINTEGER
 			TDOUBLE
 			TDOUBLE
@@ -554,67 +582,68 @@ fix_axis :	TLBRACE TAXIS_DESCR
 			TFIX_AXIS_PAR TINTEGER TINTEGER TINTEGER
 		TRBRACE TAXIS_DESCR
 		{
-			printf ("\tfix-axis\n");
-			$$ = new NFixAxis($4, $5, atol($6->c_str()), atof($7->c_str()), atof($8->c_str()), $9);
+			fprintf(stderr, "\tfix-axis\n");
+			$$ = context->descriptors->fixAxis($4, $5, $6, $7, $8, $9);
 		}
 	;
 
 axis_pts :	TLBRACE TAXIS_PTS
-			ident
+			name
 			TSTRING // std::string description
-			address //TADDRESS
-			ident
-			ident
-			TDOUBLE // std::string to double scale
-			ident
-			TINTEGER // std::string to int size
-			TDOUBLE // std::string to double min
-			TDOUBLE // std::string to double max
+			TADDRESS
+			name
+			name
+			TDOUBLE // scale
+			name
+			TINTEGER // size
+			TDOUBLE // min
+			TDOUBLE // max
 			format
 			deposit
 		TRBRACE TAXIS_PTS
 		{
-			printf("\taxis-pts: %s %s\n", $3->name.c_str(), $4->c_str());
-			$$ = new NAxisPts($3,	// name
-					*$4,	// description
+			fprintf(stderr, "\taxis-pts: %s %.*s\n", symbols().name($3).c_str(), (int) $4.length, $4.data);
+			$$ = new (context->arena) NAxisPts($3,	// name
+					context->arena.copy($4),	// description
 					$5,	// address
 					$6,	// unit
 					$7,	// ident
-					atof($8->c_str()),	// scale
+					$8,	// scale
 					$9,	//type
-					atoi($10->c_str()),	// size
-					atof($11->c_str()),	// min
-					atof($12->c_str()),	// max
+					$10,	// size
+					$11,	// min
+					$12,	// max
 					$13);	// format
 		}
 	; // axis_pts
 
-record_layout : TLBRACE TRECORD_LAYOUT ident
+record_layout : TLBRACE TRECORD_LAYOUT name
 			fnc_values
 		TRBRACE TRECORD_LAYOUT
 		{
-			$$ = NRecordLayout::createRecordLayout($3, // name
+			$$ = NRecordLayout::createRecordLayout(context->arena, $3, // name
 				$<fncValues>4); // fnc_values
 			if ($$ == NULL) { YYERROR; }
 		}
 	| // for a curve
-		TLBRACE TRECORD_LAYOUT ident
+		TLBRACE TRECORD_LAYOUT name
 			TNO_AXIS_PTS_X TINTEGER type
 			TAXIS_PTS_X TINTEGER type TINDEX_INCR TDIRECT
 			fnc_values
 		TRBRACE TRECORD_LAYOUT
 		{
-			$$ = NRecordLayout::createRecordLayout($3, // name
+			$$ = NRecordLayout::createRecordLayout(context->arena, $3, // name
 				$6, // no-type X
 				$9, // val-type X
 				0, // TODO flags
-				$<fncValues>12); // fnc_values
+				$<fncValues>12, // fnc_values
+				context->descriptors);
 
 			// $5, $8 => these integers are not used
 			if ($$ == NULL) { YYERROR; }
 		}
 	| // for a map
-		TLBRACE TRECORD_LAYOUT ident
+		TLBRACE TRECORD_LAYOUT name
 			TNO_AXIS_PTS_X TINTEGER type
 			TNO_AXIS_PTS_Y TINTEGER type
 			TAXIS_PTS_X TINTEGER type TINDEX_INCR TDIRECT
@@ -622,14 +651,15 @@ record_layout : TLBRACE TRECORD_LAYOUT ident
 			fnc_values
 		TRBRACE TRECORD_LAYOUT
 		{
-			$$ = NRecordLayout::createRecordLayout($3, // name
+			$$ = NRecordLayout::createRecordLayout(context->arena, $3, // name
 				$6, // no-type X
 				$12, // val-type X
 				0, // TODO flags
 				$9, // no-type Y
 				$17, // val-type Y
 				0, // TODO flags
-				$<fncValues>20); // fnc_values
+				$<fncValues>20, // fnc_values
+				context->descriptors);
 
 			// $5, $8, $11, $16 => these integers are not used
 			if ($$ == NULL) { YYERROR; }
@@ -639,33 +669,28 @@ record_layout : TLBRACE TRECORD_LAYOUT ident
 fnc_values : /* empty */ { $<fncValues>$ = NULL; }
 	| TFNC_VALUES TINTEGER type TCOLUMN_DIR TDIRECT
 	{
-		$<fncValues>$ = new NRecordLayout::FncValues($3, // type
+		$<fncValues>$ = context->descriptors->fncValues($3, // type
 			0); // TODO flags
 	}
 	;
 
 compu_method :	TLBRACE TCOMPU_METHOD
-			ident
+			name
 			TSTRING
 			TRAT_FUNC
 			TSTRING
 			TSTRING
-			TCOEFFS numeric numeric numeric numeric numeric numeric
+			TCOEFFS number number number number number number
 		TRBRACE TCOMPU_METHOD
 		{
-			printf("\tcompu_method: %s %s\n", $3->name.c_str(), $4->c_str());
-
-			NFormat* format = new NFormat(*$6);
-			$$ = new NCompuMethod($3,	// name
-						*$4,	// description
-						format, // format
-						*$7,	// unit
-						$9,	// number1
-						$10,	// number2
-						$11,	// number3
-						$12,	// number4
-						$13,	// number5
-						$14);	// number6
+			fprintf(stderr, "\tcompu_method: %s %.*s\n", symbols().name($3).c_str(), (int) $4.length, $4.data);
+
+			double coeffs[6] = { $9, $10, $11, $12, $13, $14 };
+			$$ = new (context->arena) NCompuMethod($3,	// name
+						context->arena.copy($4),	// description
+						parseFormat($6), // format
+						context->arena.copy($7),	// unit
+						coeffs);
 		}
 	| // boolean
 		TLBRACE TCOMPU_METHOD
@@ -677,7 +702,7 @@ compu_method :	TLBRACE TCOMPU_METHOD
 			TCOMPU_TAB_REF TB_TRUE
 		TRBRACE TCOMPU_METHOD
 		{
-			printf("\tcompu_method-boolean: %s\n", $4->c_str());
+			fprintf(stderr, "\tcompu_method-boolean: %.*s\n", (int) $4.length, $4.data);
 $$ = NULL;
 /* // TODO
 			NFormat* format = new NFormat(*$6);
@@ -695,15 +720,15 @@ $$ = NULL;
 		}
 	| // tab_intp
 		TLBRACE TCOMPU_METHOD
-			ident
+			name
 			TSTRING
 			TTAB_INTP
 			TSTRING
 			TSTRING
-			TCOMPU_TAB_REF ident
+			TCOMPU_TAB_REF name
 		TRBRACE TCOMPU_METHOD
 		{
-			printf("\tcompu_method-tab_intp: %s\n", $3->name.c_str());
+			fprintf(stderr, "\tcompu_method-tab_intp: %s\n", symbols().name($3).c_str());
 $$ = NULL;
 /* // TODO
 			NFormat* format = new NFormat(*$6);
@@ -722,7 +747,7 @@ $$ = NULL;
 	; // compu_method
 
 compu_tab :	TLBRACE TCOMPU_TAB
-			ident
+			name
 			TSTRING
 			TTAB_INTP
 			TINTEGER
@@ -737,7 +762,7 @@ compu_tab_list	: compu_tab_item { }
 		| compu_tab_list compu_tab_item { }
 	;
 
-compu_tab_item : TINTEGER numeric { delete $2; } // TODO implement
+compu_tab_item : TINTEGER numeric // TODO implement
 	;
 
 compu_vtab :	TLBRACE TCOMPU_VTAB
@@ -749,12 +774,12 @@ compu_vtab :	TLBRACE TCOMPU_VTAB
 			TINTEGER TSTRING
 		TRBRACE TCOMPU_VTAB
 		{
-			$$ = NULL;//new NStatement(); // TODO
+			$$ = NULL;//new (context->arena) NStatement(); // TODO
 		}
 	;
 
 function :	TLBRACE TFUNCTION
-			ident
+			name
 			TSTRING
 			def_characteristic
 			ref_characteristic
@@ -764,61 +789,61 @@ function :	TLBRACE TFUNCTION
 			sub_function
 		TRBRACE TFUNCTION
 		{
-			printf("\tfunction: %s %s\n", $3->name.c_str(), $4->c_str());
-			$$ = new NFunction($3, *$4, $5, $6, $7, $8, $9, $10);
+			fprintf(stderr, "\tfunction: %s %.*s\n", symbols().name($3).c_str(), (int) $4.length, $4.data);
+			$$ = new (context->arena) NFunction($3, context->arena.copy($4), $5, $6, $7, $8, $9, $10);
 		}
 	; // function
 
 
 def_characteristic :	TLBRACE TDEF_CHARACTERISTIC
-				ident_list
+				name_list
 			TRBRACE TDEF_CHARACTERISTIC
 			{ $$ = $3; }
 		;
 
 ref_characteristic :	TLBRACE TREF_CHARACTERISTIC
-				ident_list
+				name_list
 			TRBRACE TREF_CHARACTERISTIC
 			{ $$ = $3; }
 		;
 
 in_measurement :	TLBRACE TIN_MEASUREMENT
-				ident_list
+				name_list
 			TRBRACE TIN_MEASUREMENT
 			{ $$ = $3; }
 		;
 
 out_measurement :	TLBRACE TOUT_MEASUREMENT
-				ident_list
+				name_list
 			TRBRACE TOUT_MEASUREMENT
 			{ $$ = $3; }
 		;
 
 loc_measurement :	TLBRACE TLOC_MEASUREMENT
-				ident_list
+				name_list
 			TRBRACE TLOC_MEASUREMENT
 			{ $$ = $3; }
 		;
 
 sub_function :	TLBRACE TSUB_FUNCTION
-			ident_list
+			name_list
 		TRBRACE TSUB_FUNCTION
 		{ $$ = $3; }
 	;
 
-format_optional : /* empty */ { $$ = NULL; } | format { $$ = $1; }
+format_optional : /* empty */ { $$ = emptyFormat(); } | format { $$ = $1; }
 	;
 
-format : TFORMAT TSTRING { printf("\tformat: %s\n", $2->c_str()); $$ = new NFormat(*$2); }
+format : TFORMAT TSTRING { fprintf(stderr, "\tformat: %.*s\n", (int) $2.length, $2.data); $$ = parseFormat($2); }
 	;
 
 //bit_mask_optional : /* empty / { $$ = NULL; }*/ | bit_mask { $$ = $1; }
 //	;
 
-bit_mask : TBIT_MASK TADDRESS { printf("\tbit-mask: %s\n", $2->c_str()); $$ = $2; }
+bit_mask : TBIT_MASK TADDRESS { fprintf(stderr, "\tbit-mask: 0x%lX\n", $2); $$ = $2; }
 	;
 
-deposit : TDEPOSIT TABSOLUTE { printf("\tdeposite: absolute\n"); } // TODO
+deposit : TDEPOSIT TABSOLUTE { fprintf(stderr, "\tdeposite: absolute\n"); } // TODO
 	;
 
 %%
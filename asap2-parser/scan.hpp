@@ -0,0 +1,209 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Character class scanning for the hand-written lexer. Each function returns
+// the first position in [p, end) that is not part of the scanned class.
+// With SSE2 the input is tested 16 bytes at a time; the tail which does not
+// fill a whole vector is handled byte by byte, so we never read beyond end.
+namespace scan {
+
+inline bool isWhitespace(char c) { return c == ' ' || c == '\t' || c == '\n'; }
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool isIdentStart(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+inline bool isIdentChar(char c) { return isIdentStart(c) || isDigit(c); }
+inline bool isHexChar(char c)
+{
+    return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') || c == '_';
+}
+// everything but the start of a string, a comment, /begin or /end
+inline bool isPlainText(char c) { return c != '"' && c != '/'; }
+
+#ifdef __SSE2__
+// lo <= v <= hi for every byte; bytes >= 0x80 are negative and never match
+inline __m128i inRange(__m128i v, char lo, char hi)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+                         _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), v));
+}
+
+inline __m128i whitespaceMask(__m128i v)
+{
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                        _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+}
+
+inline __m128i identMask(__m128i v)
+{
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20)); // fold case
+    return _mm_or_si128(_mm_or_si128(inRange(lower, 'a', 'z'), inRange(v, '0', '9')),
+                        _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+}
+
+inline __m128i digitMask(__m128i v)
+{
+    return inRange(v, '0', '9');
+}
+
+inline __m128i hexMask(__m128i v)
+{
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    return _mm_or_si128(_mm_or_si128(inRange(lower, 'a', 'f'), inRange(v, '0', '9')),
+                        _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+}
+
+inline __m128i plainTextMask(__m128i v)
+{
+    __m128i special = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                   _mm_cmpeq_epi8(v, _mm_set1_epi8('/')));
+    return _mm_xor_si128(special, _mm_set1_epi8(-1));
+}
+
+// position of the first byte which is not matched by classMask
+template<__m128i (*classMask)(__m128i)>
+inline const char* skipVector(const char* p, const char* end)
+{
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned int mismatch = ~_mm_movemask_epi8(classMask(v)) & 0xFFFF;
+        if (mismatch != 0) {
+            return p + __builtin_ctz(mismatch);
+        }
+        p += 16;
+    }
+
+    return p;
+}
+#endif
+
+inline int countNewlines(const char* p, const char* end)
+{
+    int lines = 0;
+#ifdef __SSE2__
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        lines += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)));
+        p += 16;
+    }
+#endif
+    for (; p != end; ++p) {
+        if (*p == '\n') ++lines;
+    }
+
+    return lines;
+}
+
+// Position of the first occurrence of marker in [p, end) or end if there is
+// none. The vector loop tests 16 candidate positions at once against the
+// first and the last byte of the marker and only compares the whole marker
+// where both match.
+inline const char* find(const char* p, const char* end, const char* marker, std::size_t length)
+{
+    if (length == 0 || std::size_t(end - p) < length) {
+        return end;
+    }
+
+    const char* last = end - length; // last possible start of the marker
+#ifdef __SSE2__
+    const __m128i firstByte = _mm_set1_epi8(marker[0]);
+    const __m128i lastByte = _mm_set1_epi8(marker[length - 1]);
+    while (last - p >= 15) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + length - 1));
+        unsigned int candidates = _mm_movemask_epi8(
+                    _mm_and_si128(_mm_cmpeq_epi8(a, firstByte), _mm_cmpeq_epi8(b, lastByte)));
+
+        while (candidates != 0) {
+            const char* candidate = p + __builtin_ctz(candidates);
+            if (memcmp(candidate, marker, length) == 0) {
+                return candidate;
+            }
+            candidates &= candidates - 1;
+        }
+        p += 16;
+    }
+#endif
+    for (; p <= last; ++p) {
+        if (*p == marker[0] && memcmp(p, marker, length) == 0) {
+            return p;
+        }
+    }
+
+    return end;
+}
+
+inline const char* skipWhitespace(const char* p, const char* end, int& lines)
+{
+    const char* start = p;
+#ifdef __SSE2__
+    p = skipVector<whitespaceMask>(p, end);
+#endif
+    while (p != end && isWhitespace(*p)) ++p;
+
+    lines += countNewlines(start, p);
+    return p;
+}
+
+inline const char* skipIdentifier(const char* p, const char* end)
+{
+#ifdef __SSE2__
+    p = skipVector<identMask>(p, end);
+#endif
+    while (p != end && isIdentChar(*p)) ++p;
+    return p;
+}
+
+inline const char* skipDigits(const char* p, const char* end)
+{
+#ifdef __SSE2__
+    p = skipVector<digitMask>(p, end);
+#endif
+    while (p != end && isDigit(*p)) ++p;
+    return p;
+}
+
+inline const char* skipHexDigits(const char* p, const char* end)
+{
+#ifdef __SSE2__
+    p = skipVector<hexMask>(p, end);
+#endif
+    while (p != end && isHexChar(*p)) ++p;
+    return p;
+}
+
+inline const char* skipPlainText(const char* p, const char* end)
+{
+#ifdef __SSE2__
+    p = skipVector<plainTextMask>(p, end);
+#endif
+    while (p != end && isPlainText(*p)) ++p;
+    return p;
+}
+
+} // end namespace scan
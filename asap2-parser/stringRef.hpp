@@ -0,0 +1,50 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <ostream>
+
+// A non-owning (pointer, length) view into the lexer input. It has no
+// constructors on purpose, so it can be used as a member of bison's %union.
+struct StringRef
+{
+    const char* data;
+    std::size_t length;
+
+    std::string str() const
+    {
+        return std::string(data, length);
+    }
+
+    bool empty() const
+    {
+        return (length == 0);
+    }
+};
+
+inline StringRef makeStringRef(const char* data, std::size_t length)
+{
+    StringRef ref = { data, length };
+    return ref;
+}
+
+inline std::ostream& operator<<(std::ostream& stream, const StringRef& str)
+{
+    return stream.write(str.data, str.length);
+}
@@ -0,0 +1,183 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+
+#include "symbolTable.h"
+
+// A hash map from Symbols to the nodes of a tree. The entries are stored in
+// one array in the order they were added, so iterating is a linear scan and
+// gives the same order for the same input. A flat table of entry indices,
+// searched by linear probing, finds them; there is no allocation per entry.
+//
+// erase() moves the last entry into the gap, which changes the order of
+// that one entry.
+template<class T>
+class SymbolMap
+{
+public:
+    typedef Symbol key_type;
+    typedef T* mapped_type;
+    typedef std::pair<Symbol, T*> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    SymbolMap() : m_shift(32) { }
+
+    std::size_t size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+
+    // the bytes of the arrays
+    std::size_t memoryUsage() const
+    {
+        return m_entries.capacity() * sizeof(value_type) + m_slots.capacity() * sizeof(Index);
+    }
+
+    iterator begin() { return m_entries.begin(); }
+    iterator end() { return m_entries.end(); }
+    const_iterator begin() const { return m_entries.begin(); }
+    const_iterator end() const { return m_entries.end(); }
+
+    // makes room for count entries, so adding them never rehashes
+    void reserve(std::size_t count)
+    {
+        if (count > m_entries.capacity()) {
+            // small reserves one after another must not copy every time
+            m_entries.reserve(std::max(count, m_entries.capacity() * 2));
+        }
+        if (count > capacity()) rehash(count);
+    }
+
+    iterator find(Symbol key)
+    {
+        std::size_t slot = findSlot(key);
+        return (slot != NoSlot) ? begin() + (m_slots[slot] - 1) : end();
+    }
+
+    const_iterator find(Symbol key) const
+    {
+        std::size_t slot = findSlot(key);
+        return (slot != NoSlot) ? begin() + (m_slots[slot] - 1) : end();
+    }
+
+    // adds a NULL entry if key is new
+    T*& operator[](Symbol key)
+    {
+        std::size_t slot = findSlot(key);
+        if (slot != NoSlot) return m_entries[m_slots[slot] - 1].second;
+
+        if (m_entries.size() + 1 > capacity()) {
+            rehash(m_entries.size() * 2 + 1);
+        }
+
+        m_entries.push_back(value_type(key, static_cast<T*>(0)));
+        m_slots[freeSlot(key)] = m_entries.size();
+        return m_entries.back().second;
+    }
+
+    void erase(iterator position)
+    {
+        std::size_t index = position - begin();
+        removeSlot(findSlot(position->first));
+
+        // the last entry fills the gap
+        if (index + 1 != m_entries.size()) {
+            m_slots[findSlot(m_entries.back().first)] = index + 1;
+            m_entries[index] = m_entries.back();
+        }
+        m_entries.pop_back();
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_slots.assign(m_slots.size(), 0);
+    }
+
+private:
+    typedef boost::uint32_t Index; // entry index + 1, 0 marks a free slot
+
+    enum { MinBits = 3 };
+    static const std::size_t NoSlot = ~std::size_t(0);
+
+    // at most 3/4 of the slots are used, longer probe sequences cost more
+    // than the memory they save
+    std::size_t capacity() const { return m_slots.size() / 4 * 3; }
+
+    // Fibonacci hashing: the symbols are consecutive numbers, the
+    // multiplication spreads them over the upper bits
+    std::size_t home(Symbol key) const
+    {
+        return boost::uint32_t(key * 2654435769u) >> m_shift;
+    }
+
+    std::size_t mask() const { return m_slots.size() - 1; }
+
+    std::size_t findSlot(Symbol key) const
+    {
+        if (m_slots.empty()) return NoSlot;
+
+        for (std::size_t slot = home(key); ; slot = (slot + 1) & mask()) {
+            Index index = m_slots[slot];
+            if (index == 0) return NoSlot;
+            if (m_entries[index - 1].first == key) return slot;
+        }
+    }
+
+    std::size_t freeSlot(Symbol key) const
+    {
+        std::size_t slot = home(key);
+        while (m_slots[slot] != 0) slot = (slot + 1) & mask();
+        return slot;
+    }
+
+    // backward shift deletion, so no tombstones are needed
+    void removeSlot(std::size_t hole)
+    {
+        for (std::size_t slot = (hole + 1) & mask(); m_slots[slot] != 0; slot = (slot + 1) & mask()) {
+            std::size_t wanted = home(m_entries[m_slots[slot] - 1].first);
+
+            // may it move to the hole, without passing its home slot?
+            if (((slot - wanted) & mask()) >= ((slot - hole) & mask())) {
+                m_slots[hole] = m_slots[slot];
+                hole = slot;
+            }
+        }
+        m_slots[hole] = 0;
+    }
+
+    void rehash(std::size_t count)
+    {
+        unsigned bits = MinBits;
+        while ((std::size_t(1) << bits) / 4 * 3 < count) ++bits;
+
+        m_shift = 32 - bits;
+        m_slots.assign(std::size_t(1) << bits, 0);
+        for (std::size_t i = 0; i < m_entries.size(); ++i) {
+            m_slots[freeSlot(m_entries[i].first)] = i + 1;
+        }
+    }
+
+    std::vector<value_type> m_entries;  // in the order they were added
+    std::vector<Index> m_slots;         // size is a power of two
+    unsigned m_shift;                   // 32 - log2(m_slots.size())
+};
@@ -0,0 +1,129 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>
+
+#include "symbolTable.h"
+
+namespace {
+
+SymbolTable processSymbols;
+thread_local SymbolTable* currentSymbols = NULL;
+
+} // namespace
+
+SymbolTable& symbols()
+{
+    return (currentSymbols != NULL) ? *currentSymbols : processSymbols;
+}
+
+SymbolScope::SymbolScope(SymbolTable& table) :
+    m_previous(currentSymbols)
+{
+    currentSymbols = &table;
+}
+
+SymbolScope::~SymbolScope()
+{
+    currentSymbols = m_previous;
+}
+
+SymbolTable::SymbolTable() :
+    m_count(0),
+    m_nameBytes(0)
+{
+    for (int i = 0; i < SegmentCount; ++i) {
+        m_segments[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+SymbolTable::~SymbolTable()
+{
+    for (int i = 0; i < SegmentCount; ++i) {
+        delete[] m_segments[i].load(std::memory_order_relaxed);
+    }
+}
+
+Symbol SymbolTable::intern(const char* str, std::size_t length)
+{
+    std::string_view view(str, length);
+    Shard& shard = m_shards[(ViewHash()(view) >> 8) % ShardCount];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    boost::unordered_map<std::string_view, Symbol, ViewHash>::const_iterator it = shard.index.find(view);
+    if (it != shard.index.end()) return it->second;
+
+    Symbol symbol = m_count.fetch_add(1, std::memory_order_relaxed);
+    shard.names.push_back(std::string(str, length));
+
+    const std::string& name = shard.names.back();
+    shard.index.emplace(std::string_view(name.data(), name.size()), symbol);
+    m_nameBytes.fetch_add(name.capacity() + 1, std::memory_order_relaxed);
+    setName(symbol, &name);
+    return symbol;
+}
+
+bool SymbolTable::find(const char* str, std::size_t length, Symbol* symbol)
+{
+    std::string_view view(str, length);
+    Shard& shard = m_shards[(ViewHash()(view) >> 8) % ShardCount];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    boost::unordered_map<std::string_view, Symbol, ViewHash>::const_iterator it = shard.index.find(view);
+    if (it == shard.index.end()) return false;
+
+    *symbol = it->second;
+    return true;
+}
+
+void SymbolTable::setName(Symbol symbol, const std::string* name)
+{
+    if ((symbol >> SegmentBits) >= SegmentCount) {
+        throw std::length_error("too many symbols");
+    }
+
+    std::atomic<const std::string**>& slot = m_segments[symbol >> SegmentBits];
+
+    const std::string** segment = slot.load(std::memory_order_acquire);
+    if (segment == 0) {
+        // another shard may allocate the same segment at the same time
+        const std::string** fresh = new const std::string*[SegmentSize];
+        if (slot.compare_exchange_strong(segment, fresh, std::memory_order_acq_rel)) {
+            segment = fresh;
+        }
+        else {
+            delete[] fresh;
+        }
+    }
+
+    segment[symbol & (SegmentSize - 1)] = name;
+}
+
+std::size_t SymbolTable::memoryUsage() const
+{
+    // per name: the string, its index node and bucket; the segments and
+    // the shards are allocated for the table
+    const std::size_t perName = sizeof(std::string) + sizeof(std::string_view) + sizeof(Symbol) + 3 * sizeof(void*);
+
+    std::size_t segments = 0;
+    for (int i = 0; i < SegmentCount; ++i) {
+        if (m_segments[i].load(std::memory_order_acquire) != 0) ++segments;
+    }
+
+    return sizeof(SymbolTable) + m_nameBytes + m_count * perName + segments * SegmentSize * sizeof(const std::string*);
+}
@@ -0,0 +1,116 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <boost/unordered_map.hpp>
+#include <boost/cstdint.hpp>
+
+// Identifiers are interned: every distinct name is stored once and the
+// tree refers to it by a 32-bit id. Two identifiers are equal iff their
+// symbols are equal.
+typedef boost::uint32_t Symbol;
+
+// intern() may be called from several parser threads at once. The names
+// are spread over shards with a lock each, the id -> name table is read
+// without locking.
+class SymbolTable
+{
+public:
+    SymbolTable();
+    ~SymbolTable();
+
+    // returns the symbol of str[0, length), adding the name if it is new
+    Symbol intern(const char* str, std::size_t length);
+    Symbol intern(const std::string& str) { return intern(str.data(), str.size()); }
+
+    // like intern(), but never adds a name; returns false for unknown names
+    bool find(const char* str, std::size_t length, Symbol* symbol);
+    bool find(const std::string& str, Symbol* symbol) { return find(str.data(), str.size(), symbol); }
+
+    const std::string& name(Symbol symbol) const
+    {
+        const std::string** segment = m_segments[symbol >> SegmentBits].load(std::memory_order_acquire);
+        return *segment[symbol & (SegmentSize - 1)];
+    }
+
+    std::size_t size() const { return m_count; }
+
+    // the bytes the names and their index take, roughly
+    std::size_t memoryUsage() const;
+
+private:
+    // noncopyable, the indices point into the names
+    SymbolTable(const SymbolTable&);
+    SymbolTable& operator=(const SymbolTable&);
+
+    enum {
+        ShardCount = 64,
+        SegmentBits = 16,
+        SegmentSize = 1 << SegmentBits,
+        SegmentCount = 4096 // up to 2^28 names
+    };
+
+    struct ViewHash
+    {
+        std::size_t operator()(std::string_view view) const
+        {
+            return boost::hash_range(view.begin(), view.end());
+        }
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::deque<std::string> names; // a deque never moves its elements
+        boost::unordered_map<std::string_view, Symbol, ViewHash> index;
+    };
+
+    void setName(Symbol symbol, const std::string* name);
+
+    Shard m_shards[ShardCount];
+    std::atomic<Symbol> m_count;
+    std::atomic<std::size_t> m_nameBytes; // of the strings, as they are added
+    // symbol -> name, allocated in segments so it never has to move
+    std::atomic<const std::string**> m_segments[SegmentCount];
+};
+
+// The names of the trees the calling thread works on. This is one table for
+// the whole process unless a SymbolScope selects another one, e.g. one per
+// model of ModelServer, so the names are released with their model.
+SymbolTable& symbols();
+
+// Selects table for the calling thread while it exists. Threads which work
+// on the same trees need a scope of their own.
+class SymbolScope
+{
+public:
+    explicit SymbolScope(SymbolTable& table);
+    ~SymbolScope();
+
+private:
+    // noncopyable
+    SymbolScope(const SymbolScope&);
+    SymbolScope& operator=(const SymbolScope&);
+
+    SymbolTable* m_previous;
+};
@@ -0,0 +1,131 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "threadPool.h"
+
+ThreadPool::ThreadPool(unsigned threads) :
+    m_nextQueue(0),
+    m_pending(0),
+    m_queued(0),
+    m_stop(false)
+{
+    if (threads == 0) threads = 1;
+
+    for (unsigned i = 0; i < threads; ++i) {
+        m_queues.push_back(new Queue());
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        m_threads.push_back(std::thread(&ThreadPool::run, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeup.notify_all();
+
+    for (std::size_t i = 0; i < m_threads.size(); ++i) {
+        m_threads[i].join();
+    }
+    for (std::size_t i = 0; i < m_queues.size(); ++i) {
+        delete m_queues[i];
+    }
+}
+
+void ThreadPool::submit(const Task& task)
+{
+    // spread over the queues, the workers steal to balance the rest
+    Queue& queue = *m_queues[m_nextQueue.fetch_add(1) % m_queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_pending;
+        ++m_queued;
+    }
+    m_wakeup.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_pending != 0) {
+        m_idle.wait(lock);
+    }
+}
+
+bool ThreadPool::pop(unsigned self, Task& task)
+{
+    // the own queue from the back, it is most likely still in the cache
+    {
+        Queue& own = *m_queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task.swap(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // steal the oldest task of another worker
+    for (std::size_t i = 1; i < m_queues.size(); ++i) {
+        Queue& victim = *m_queues[(self + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task.swap(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::run(unsigned self)
+{
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (m_queued == 0 && !m_stop) {
+                m_wakeup.wait(lock);
+            }
+            if (m_queued == 0) {
+                return; // stopped and nothing left
+            }
+            --m_queued; // reserves one of the queued tasks
+        }
+
+        Task task;
+        while (!pop(self, task)) {
+            std::this_thread::yield(); // it is pushed, but not visible yet
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0) {
+            m_idle.notify_all();
+        }
+    }
+}
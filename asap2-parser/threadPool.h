@@ -0,0 +1,71 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+// A fixed set of worker threads with a task queue each. A worker takes its
+// newest task first and steals the oldest one of another worker when its
+// own queue is empty, so long and short tasks balance out.
+class ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool(); // waits for all tasks
+
+    // may be called from any thread, also from a running task
+    void submit(const Task& task);
+
+    // blocks until every submitted task has finished
+    void wait();
+
+    unsigned size() const { return m_queues.size(); }
+
+private:
+    // noncopyable
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(unsigned self);
+    bool pop(unsigned self, Task& task);
+
+    std::vector<Queue*> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<unsigned> m_nextQueue;
+
+    std::mutex m_mutex;                 // guards the counters below
+    std::condition_variable m_wakeup;   // a task was submitted, or stop
+    std::condition_variable m_idle;     // m_pending dropped to 0
+    std::size_t m_pending;              // submitted, but not finished
+    std::size_t m_queued;               // submitted, but not started
+    bool m_stop;
+};
@@ -14,6 +14,9 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <charconv>
+#include <cstring>
+
 #include "util.h"
 
 #include "node.h"
@@ -52,3 +55,31 @@ void getDataTypeInfo(int type, short* sizeInBits, bool* isSigned)
         return;
     }
 }
+
+long toLong(const StringRef& str)
+{
+    long value = 0;
+    std::from_chars(str.data, str.data + str.length, value);
+    return value;
+}
+
+boost::uint64_t contentHash(const char* p, const char* end)
+{
+    const boost::uint64_t m = 0xff51afd7ed558ccdULL;
+    boost::uint64_t h = 0x9e3779b97f4a7c15ULL ^ boost::uint64_t(end - p);
+
+    for (; end - p >= 8; p += 8) {
+        boost::uint64_t word;
+        memcpy(&word, p, 8);
+        h = (h ^ word) * m;
+        h ^= h >> 32;
+    }
+
+    for (; p != end; ++p) {
+        h = (h ^ (unsigned char) *p) * m;
+    }
+
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 33);
+}
@@ -18,24 +18,15 @@
 
 #include <string>
 #include <stdexcept>
+#include <boost/cstdint.hpp>
 
-inline std::string getAddressSubstr(const std::string& base)
-{
-    if (base.size() < 3)
-        throw std::out_of_range ("const std::string& base");
-
-    return base.substr(2);
-}
+#include "stringRef.hpp"
 
 void getDataTypeInfo(int type, short* sizeInBits, bool* isSigned);
 
-template<class T>
-void deleteAndClear(T& container)
-{
-    for (typename T::iterator it = container.begin();
-         it != container.end(); ++it ) {
-        delete *it;
-    }
+// integer value of a string token, 0 if it is not a number
+long toLong(const StringRef& str);
 
-    container.clear();
-}
+// 64-bit hash of [begin, end); not cryptographic, it only has to notice
+// edits of the input
+boost::uint64_t contentHash(const char* begin, const char* end);
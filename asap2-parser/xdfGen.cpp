@@ -16,71 +16,70 @@
 
 #include <cassert>
 #include <cmath>
+#include <charconv>
+#include <algorithm>
 
 #include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <memory>
 
 #include "xdfGen.h"
+#include "linker.h"
 #include "util.h"
 
 XdfGen::XdfGen(
     const NModule& module,
+    const CrossReference& references,
+    std::ostream& out,
     int offset) :
     m_done(false),
     m_module(module),
+    m_references(references),
     m_offset(offset),
-    m_baseStream(std::stringstream::out),
-    m_xdf(m_baseStream)
+    m_out(out),
+    m_xdf(out)
 {
     createHeader();
 }
 
+XdfGen::XdfGen(const XdfGen& generator, std::ostream& out) :
+    m_done(true), // the document is closed by generator
+    m_module(generator.m_module),
+    m_references(generator.m_references),
+    m_offset(generator.m_offset),
+    m_out(out),
+    m_xdf(out)
+{
+    m_xdf.resume(xml::startTag("XDFFORMAT"));
+}
+
 void XdfGen::createCategorys()
 {
     int n = 0;
-    m_xdf << std::hex;
 
     const FunctionHashMap& functions = m_module.functions;
     BOOST_FOREACH (FunctionHashMap::value_type i, functions) {
-        const std::string& name = i.second->id->name;
+        const std::string& name = i.second->name();
 
-        m_categorys[name] = n; // save our xdf-id
-
-        m_xdf << xml::startTag("CATEGORY") << xml::attribute("index") << "0x" << n
+        assert(m_references.category(i.first) == n); // the CATEGORYMEMs use it
+        m_xdf << xml::startTag("CATEGORY") << xml::attribute("index") << xml::hex(n)
               << xml::attribute("name") << name << ": "
               << i.second->description << xml::endTag;
         ++n;
     }
-
-    m_xdf << std::dec;
-}
-
-void XdfGen::createCategoryReferences(const NIdentifier& id,
-                                      const NIdentifier& func_id,
-                                      const ExpressionList& refs)
-{
-    m_xdf << std::dec;
-
-    // iterate throug our identifiers in refs
-    BOOST_FOREACH (ExpressionList::value_type i, refs) {
-
-        // its not guaranteed to be an NIdentifier
-        const NIdentifier* d_id = dynamic_cast<const NIdentifier*>(i);
-        if (d_id != NULL && id.name == d_id->name) {
-            m_xdf << xml::startTag("CATEGORYMEM") << xml::attribute("index") << 0 // TODO index
-                  << xml::attribute("category")
-                  << m_categorys[func_id.name] + 1 // the reference is the index + 1 in decimal
-                  << xml::endTag;
-        }
-    }
 }
 
-void XdfGen::createCatRefsForMap(const NIdentifier& id)
+void XdfGen::createCatRefsForMap(Symbol id)
 {
-    const FunctionHashMap& functions = m_module.functions;
-    BOOST_FOREACH (FunctionHashMap::value_type i, functions) {
-
-        createCategoryReferences(id, * i.second->id, * i.second->def_characteristic);
-        createCategoryReferences(id, * i.second->id, * i.second->ref_characteristic);
+    CrossReference::Range functions = m_references.characteristic(id);
+    for (const CrossReference::Reference* i = functions.first; i != functions.second; ++i) {
+        m_xdf << xml::startTag("CATEGORYMEM") << xml::attribute("index") << 0 // TODO index
+              << xml::attribute("category")
+              << i->category + 1 // the reference is the index + 1 in decimal
+              << xml::endTag;
     }
 }
 
@@ -111,12 +110,12 @@ void XdfGen::createHeader()
     m_xdf << xml::endTag; // close header tag
 }
 
-void XdfGen::createMathEquation(
+XdfGen::MathEquation XdfGen::mathEquation(
     short typeSize,
     bool typeSign,
     double max, double min)
 {
-    float factor, offset, district;
+    float factor, offset = 0, district;
     int typeMax;
 
     typeMax = (1 << typeSize) - 1;
@@ -124,9 +123,36 @@ void XdfGen::createMathEquation(
     factor = district / typeMax;
     if (!typeSign) offset = min;
 
-    m_xdf << xml::startTag("MATH") << xml::attribute("equation") << factor << " * X";
+    // like the default format of a stream, %g with 6 digits
+    MathEquation equation;
+    char* pos = equation.text;
+    char* end = equation.text + sizeof(equation.text);
+    pos = std::to_chars(pos, end, factor, std::chars_format::general, 6).ptr;
+    pos = std::copy(" * X", " * X" + 4, pos);
 
-    if (offset != 0) m_xdf << "+ " << offset;
+    if (offset != 0) {
+        pos = std::copy("+ ", "+ " + 2, pos);
+        pos = std::to_chars(pos, end, offset, std::chars_format::general, 6).ptr;
+    }
+
+    equation.length = pos - equation.text;
+    return equation;
+}
+
+const XdfGen::MathEquation& XdfGen::axisEquation(const NAxis& axis, short typeSize, bool typeSign)
+{
+    // typeSize and typeSign come from the axis as well
+    EquationHashMap::iterator i = m_axisEquations.find(&axis);
+    if (i == m_axisEquations.end()) {
+        i = m_axisEquations.insert(std::make_pair(&axis, mathEquation(typeSize, typeSign, axis.max, axis.min))).first;
+    }
+    return i->second;
+}
+
+void XdfGen::createMathEquation(const MathEquation& equation)
+{
+    m_xdf << xml::startTag("MATH") << xml::attribute("equation")
+          << makeStringRef(equation.text, equation.length);
 
     m_xdf << xml::startTag("VAR") << xml::attribute("id") << "X" << xml::endTag
           << xml::endTag;
@@ -138,8 +164,7 @@ void XdfGen::epilogue()
 
     m_xdf << xml::endTag;
     m_done = true;
-    // TESTING
-    std::cout << m_xdf.str() << std::endl;
+    m_out << std::endl;
 }
 
 static inline int getTypeFlags(bool msbLast, bool typeSign)
@@ -151,56 +176,64 @@ static inline int getTypeFlags(bool msbLast, bool typeSign)
     return typeFlags;
 }
 
+// the references handleAxis() follows; dangling ones are reported by the link
+static inline bool isLinked(const NAxis& axis)
+{
+    if (axis.dataTypeRef == NULL || axis.compuMethodRef == NULL) return false;
+
+    return axis.getAxisStyle() != Extern
+        || static_cast<const NComAxis&>(axis).axisPtsRef != NULL;
+}
+
+unsigned int XdfGen::locateAxis(const NComAxis& axis, unsigned int baseAddr, short typeSize, int& offset)
+{
+    std::clog << "handle com axis" << std::endl;
+    offset = 0; // a com-axis does not affect our map address
+    return axis.axisPtsRef->address;
+}
+
+unsigned int XdfGen::locateAxis(const NStdAxis& axis, unsigned int baseAddr, short typeSize, int& offset)
+{
+    std::clog << "handle std axis" << std::endl;
+    unsigned int startAddr = baseAddr + offset;
+    offset = (axis.length * typeSize) / 8; // gesamtgröße
+    return startAddr;
+}
+
+unsigned int XdfGen::locateAxis(const NFixAxis& axis, unsigned int baseAddr, short typeSize, int& offset)
+{
+    std::clog << "handle fix axis" << std::endl;
+    offset += 0; // a fix-axis does not affect our map address
+    return 0; // its values are not stored
+}
+
+template<class Axis>
 unsigned int XdfGen::handleAxis(
-    const NAxis& axis,
+    const Axis& axis,
     unsigned int baseAddr,
     const char* name)
 {
-    const NMeasurement* measurement = m_module.measurements.at(axis.m_dataType->name);
-    assert(measurement != NULL);
+    assert(isLinked(axis));
+    const NMeasurement* measurement = axis.dataTypeRef;
 
     short typeSize;
     bool typeSign, msbLast = true; // TODO: endianness
     getDataTypeInfo(measurement->dataType, &typeSize, &typeSign);
 
     int offset = m_offset;
-    unsigned int startAddr;
-
-    AxisStyle axisStyle = axis.getAxisStyle();
-    if (axisStyle == Extern) {
-        const NComAxis* comAxis = dynamic_cast<const NComAxis*>(&axis);
-        assert(comAxis != NULL);
-        std::cout << "handle com axis" << std::endl;
-        offset = 0; // a com-axis does not affect our map address
-        const NAxisPts* axisPts = m_module.axisPts.at(comAxis->m_axis_pts->name);
-        startAddr = axisPts->m_address->value;
-    }
-    else if (axisStyle == Intern) {
-        const NStdAxis* stdAxis = dynamic_cast<const NStdAxis*>(&axis);
-        assert(stdAxis != NULL);
-        std::cout << "handle std axis" << std::endl;
-        startAddr = baseAddr + offset;
-        offset = (stdAxis->length * typeSize) / 8; // gesamtgröße
-    }
-    else if (axisStyle == Fixed) {
-        const NFixAxis* fixAxis = dynamic_cast<const NFixAxis*>(&axis);
-        assert(fixAxis != NULL);
-        std::cout << "handle fix axis" << std::endl;
-        offset += 0; // a fix-axis does not affect our map address
-    }
+    unsigned int startAddr = locateAxis(axis, baseAddr, typeSize, offset);
 
-    const NCompuMethod* compuMethod = m_module.compuMethods.at(axis.m_compuMethod->name);
-    assert(compuMethod != NULL);
+    const NCompuMethod* compuMethod = axis.compuMethodRef;
 
-    std::string units = compuMethod->unit;
-    if (units.empty()) units = "-";
+    StringRef units = compuMethod->unit;
+    if (units.empty()) units = makeStringRef("-", 1);
 
     // generate:
     m_xdf << xml::startTag("XDFAXIS") << xml::attribute("id") << name
           << xml::attribute("uniqueid") << "0x0" // TODO uniqueid
           << xml::startTag("EMBEDDEDDATA") << xml::attribute("mmedtypeflags")
-          << std::hex << "0x" << getTypeFlags(msbLast, typeSign)
-          << xml::attribute("mmedaddress") << "0x" << startAddr << std::dec
+          << xml::hex(getTypeFlags(msbLast, typeSign))
+          << xml::attribute("mmedaddress") << xml::hex(startAddr)
           << xml::attribute("mmedelementsizebits") << typeSize
           << xml::attribute("mmedcolcount") << axis.length
           << xml::attribute("mmedmajorstridebits") << typeSize // should be the same as mmedelementsizebits
@@ -208,14 +241,13 @@ unsigned int XdfGen::handleAxis(
           << xml::startTag("units") << xml::content << units << xml::endTag
           << xml::startTag("indexcount") << xml::content << axis.length << xml::endTag
           << xml::startTag("decimalpl") << xml::content
-          << compuMethod->m_format->getDecimalPl() << xml::endTag
+          << compuMethod->format.decimalPl << xml::endTag
           << xml::startTag("embedinfo") << xml::attribute("type") << 1 << xml::endTag
           << xml::startTag("datatype") << xml::content << 0 << xml::endTag
           << xml::startTag("unittype") << xml::content << 0 << xml::endTag
           << xml::startTag("DALINK") << xml::attribute("index") << 0 << xml::endTag;
 
-//    double factor, d_offset;
-    createMathEquation(typeSize, typeSign, axis.max, axis.min);//, factor, d_offset);
+    createMathEquation(axisEquation(axis, typeSize, typeSign));
 
     m_xdf << xml::endTag;
 
@@ -225,69 +257,91 @@ unsigned int XdfGen::handleAxis(
 // all top-level statements
 void XdfGen::visit(NBaseMap* elem)
 {
-    std::cout << "visiting NMap " << elem->id->name << std::endl;
+    dispatchMap(*elem, *this);
+}
 
-    m_xdf << xml::startTag("XDFTABLE")
-          << xml::attribute("uniqueid") << "0x0" // TODO
-          << xml::attribute("falgs") << "0x0"
-          << xml::startTag("title") << xml::content << elem->id->name << xml::endTag
-          << xml::startTag("description") << xml::content << elem->description << xml::endTag; // TODO: umlaute!
+void XdfGen::operator()(NMap<NComAxis>& elem) { generateMap(elem); }
+void XdfGen::operator()(NMap<NStdAxis>& elem) { generateMap(elem); }
+void XdfGen::operator()(NMap<NFixAxis>& elem) { generateMap(elem); }
+
+unsigned int XdfGen::handleMapAxes(const NMap<NStdAxis>& map, const NRecordLayout& recordLayout)
+{
+    std::clog << "with std-axis\n";
+    return handleStdMap(&map, recordLayout);
+}
+
+unsigned int XdfGen::handleMapAxes(const NMap<NComAxis>& map, const NRecordLayout& recordLayout)
+{
+    std::clog << "with com-axis\n";
+    handleComMap(&map);
+    return 0;
+}
+
+unsigned int XdfGen::handleMapAxes(const NMap<NFixAxis>& map, const NRecordLayout& recordLayout)
+{
+    std::clog << "with fix-axis\n";
+    return 0;
+}
+
+template<class Axis>
+void XdfGen::generateMap(const NMap<Axis>& map)
+{
+    const NMap<Axis>* elem = &map;
+    std::clog << "visiting NMap " << elem->name() << std::endl;
 
-    const NRecordLayout* recordLayout = m_module.recordLayouts.at(elem->m_recordLayout->name);
-    assert(recordLayout != NULL);
+    // skipped, the link has reported the missing objects
+    const NRecordLayout* recordLayout = elem->recordLayoutRef;
+    const NCompuMethod* compuMethod = elem->compuMethodRef;
+    if (recordLayout == NULL || compuMethod == NULL) return;
+    if (Axis::style != Fixed && (!isLinked(elem->m_axis_1.ref()) || !isLinked(elem->m_axis_2.ref()))) return;
 
+    // skipped as well, the record layout does not describe the map
     if (!recordLayout->hasFncValues()) {
-        std::cerr << "NRecordLayout for the map: " << elem->id->name
+        std::cerr << "NRecordLayout for the map: " << elem->name()
                   << " should have an FNC_VALUES entry!" << std::endl;
-        throw std::exception();
-    }
-
-    int offset = m_offset;
-    unsigned int startAddr;
-    if (elem->axisStyle() == Intern) {
-        std::cout << "with std-axis\n";
-        const NMap<NStdAxis>* stdMap = dynamic_cast<const NMap<NStdAxis>*>(elem);
-        offset += handleStdMap(stdMap, *recordLayout);
-    }
-    else if (elem->axisStyle() == Extern) {
-        std::cout << "with com-axis\n";
-        const NMap<NComAxis>* comMap = dynamic_cast<const NMap<NComAxis>*>(elem);
-        handleComMap(comMap);
+        return;
     }
-    else if (elem->axisStyle() == Fixed) {
-        std::cout << "with fix-axis\n";
+    if (Axis::style == Intern && (!recordLayout->hasXAxis() || !recordLayout->hasYAxis())) {
+        std::cerr << "NRecordLayout for the map: " << elem->name()
+                  << " is missing the axis description!" << std::endl;
+        return;
     }
 
+    m_xdf << xml::startTag("XDFTABLE")
+          << xml::attribute("uniqueid") << "0x0" // TODO
+          << xml::attribute("falgs") << "0x0"
+          << xml::startTag("title") << xml::content << elem->name() << xml::endTag
+          << xml::startTag("description") << xml::content << elem->description << xml::endTag;
+
+    int offset = m_offset + handleMapAxes(map, *recordLayout);
+
     // final data address
-    startAddr = elem->m_address->value + offset;
+    unsigned int startAddr = elem->address + offset;
 
     short typeSize;
     bool typeSign, msbLast = true; // TODO: endianness
     getDataTypeInfo(recordLayout->getFncValues().type, &typeSize, &typeSign);
 
     // CompuMethod data:
-    const NCompuMethod* compuMethod = m_module.compuMethods.at(elem->m_compuMethod->name);
-    assert(compuMethod != NULL);
-
-    std::string units = compuMethod->unit;
-    if (units.empty()) units = "-";
+    StringRef units = compuMethod->unit;
+    if (units.empty()) units = makeStringRef("-", 1);
 
     // create final Axis
     m_xdf << xml::startTag("XDFAXIS") << xml::attribute("id") << "z"
           << xml::startTag("EMBEDDEDDATA") << xml::attribute("mmedtypeflags")
-          << std::hex << "0x" << getTypeFlags(msbLast, typeSign)
-          << xml::attribute("mmedaddress") << "0x" << startAddr << std::dec
+          << xml::hex(getTypeFlags(msbLast, typeSign))
+          << xml::attribute("mmedaddress") << xml::hex(startAddr)
           << xml::attribute("mmedelementsizebits") << typeSize
-          << xml::attribute("mmedrowcount") << elem->axisXlength()
-          << xml::attribute("mmedcolcount") << elem->axisYlength()
+          << xml::attribute("mmedrowcount") << elem->m_axis_1->length
+          << xml::attribute("mmedcolcount") << elem->m_axis_2->length
           << xml::endTag
-          << xml::startTag("units") << xml::content(units) << xml::endTag
-          << xml::startTag("decimalpl") << xml::content << elem->m_format->getDecimalPl() << xml::endTag
+          << xml::startTag("units") << xml::content << units << xml::endTag
+          << xml::startTag("decimalpl") << xml::content << elem->format.decimalPl << xml::endTag
           << xml::startTag("min") << xml::content << elem->min << xml::endTag
           << xml::startTag("max") << xml::content << elem->max << xml::endTag
           << xml::startTag("outputtype") << xml::content << 1 << xml::endTag;
 
-    createMathEquation(typeSize, typeSign, elem->max, elem->min);
+    createMathEquation(mathEquation(typeSize, typeSign, elem->max, elem->min));
 
     m_xdf << xml::endTag(2);
 }
@@ -296,15 +350,10 @@ void XdfGen::handleComMap(const NMap<NComAxis>* comMap)
 {
     assert(comMap != NULL);
 
-    createCatRefsForMap(*comMap->id);
-    try {
-        handleAxis(*comMap->m_axis_1.get(), comMap->m_address->value, "x");
-        handleAxis(*comMap->m_axis_2.get(), comMap->m_address->value, "y");
-    }
-    catch (std::out_of_range& e) {
-//    catch (std::exception& e) {
-        std::cerr << "std::out_of_range exception in handleComMap" << std::endl;
-    }
+    createCatRefsForMap(comMap->id);
+
+    handleAxis(comMap->m_axis_1.ref(), comMap->address, "x");
+    handleAxis(comMap->m_axis_2.ref(), comMap->address, "y");
 }
 
 unsigned int XdfGen::handleStdMap(
@@ -312,12 +361,7 @@ unsigned int XdfGen::handleStdMap(
     const NRecordLayout& recordLayout)
 {
     assert(stdMap != NULL);
-
-    if (!recordLayout.hasXAxis() || !recordLayout.hasYAxis()) {
-        std::cerr << "NRecordLayout for the map: " << stdMap->id->name
-                  << " is missing the axis description!" << std::endl;
-        throw std::exception();
-    }
+    assert(recordLayout.hasXAxis() && recordLayout.hasYAxis()); // see generateMap()
 
     int noTypeX = recordLayout.getXAxis().NoAxisType;
     int noTypeY = recordLayout.getYAxis().NoAxisType;
@@ -331,17 +375,12 @@ unsigned int XdfGen::handleStdMap(
     unsigned int offset = (typeSizeX + typeSignY) / 8;
     unsigned int axisAddr;
 
-    createCatRefsForMap(*stdMap->id);
-    try {
-        axisAddr = stdMap->m_address->value + offset;
-        offset += handleAxis(*stdMap->m_axis_1.get(), axisAddr, "x");
-        axisAddr = stdMap->m_address->value + offset; // adjust with new offset
-        offset += handleAxis(*stdMap->m_axis_2.get(), axisAddr, "y");
-    }
-    catch (std::out_of_range& e) {
-//    catch (std::exception& e) {
-        std::cerr << "std::out_of_range exception in handleStdMap" << std::endl;
-    }
+    createCatRefsForMap(stdMap->id);
+
+    axisAddr = stdMap->address + offset;
+    offset += handleAxis(stdMap->m_axis_1.ref(), axisAddr, "x");
+    axisAddr = stdMap->address + offset; // adjust with new offset
+    offset += handleAxis(stdMap->m_axis_2.ref(), axisAddr, "y");
 
     return offset;
 }
@@ -350,12 +389,12 @@ void XdfGen::handleFixMap(const NMap<NFixAxis>* fixMap)
 {
     assert(fixMap != NULL);
 
-    std::cout << "handle fix map" << std::endl;
+    std::clog << "handle fix map" << std::endl;
 }
 
 void XdfGen::visit(NCurve* elem)
 {
-    std::cout << "visiting NCurve " << elem->id->name << std::endl;
+    std::clog << "visiting NCurve " << elem->name() << std::endl;
 
 }
 
@@ -402,10 +441,363 @@ void XdfGen::visit(NRecordLayout* elem)
 // inner statements
 void XdfGen::visit(NConstant* elem)
 {
-    printf("NConstant is invalid in this context!\n");
+    std::cerr << "NConstant is invalid in this context!" << std::endl;
 }
 
 void XdfGen::visit(NVariable* elem)
 {
-    printf("NVariable is invalid in this context!\n");
+    std::cerr << "NVariable is invalid in this context!" << std::endl;
+}
+
+namespace {
+
+// Has to change whenever the tables are rendered differently; the
+// fragments stored by an older build are not used then.
+const boost::uint64_t TableFormat = 2;
+
+// FNV-1a over the inputs of a table
+class KeyHasher
+{
+public:
+    KeyHasher() : m_hash(0xcbf29ce484222325ULL) { }
+
+    void bytes(const void* data, std::size_t size)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            m_hash = (m_hash ^ p[i]) * 0x100000001b3ULL;
+        }
+    }
+
+    void integer(boost::int64_t value) { bytes(&value, sizeof(value)); }
+    void number(double value) { bytes(&value, sizeof(value)); }
+
+    void text(const char* data, std::size_t length)
+    {
+        integer(length);
+        bytes(data, length);
+    }
+
+    void text(const StringRef& str) { text(str.data, str.length); }
+    void text(const std::string& str) { text(str.data(), str.size()); }
+
+    boost::uint64_t value() const { return m_hash; }
+
+private:
+    boost::uint64_t m_hash;
+};
+
+// what XdfGen reads of each kind of characteristic, for dispatchCharacteristic()
+class TableInputs
+{
+public:
+    TableInputs(KeyHasher& hash, const CrossReference& references) :
+        m_hash(hash),
+        m_references(references) { }
+
+    template<class Axis>
+    void operator()(NMap<Axis>& map)
+    {
+        characteristic(map);
+        m_hash.integer(map.axisStyle());
+
+        const NRecordLayout* recordLayout = map.recordLayoutRef;
+        m_hash.integer(recordLayout != NULL);
+        if (recordLayout != NULL) {
+            m_hash.integer(recordLayout->hasFncValues() ? recordLayout->getFncValues().type : -1);
+            m_hash.integer(recordLayout->hasXAxis() ? recordLayout->getXAxis().NoAxisType : -1);
+            m_hash.integer(recordLayout->hasYAxis() ? recordLayout->getYAxis().NoAxisType : -1);
+        }
+
+        compuMethod(map.compuMethodRef);
+        axis(map.m_axis_1.ref());
+        axis(map.m_axis_2.ref());
+
+        CrossReference::Range functions = m_references.characteristic(map.id);
+        for (const CrossReference::Reference* i = functions.first; i != functions.second; ++i) {
+            m_hash.integer(i->category);
+        }
+    }
+
+    // not rendered yet
+    void operator()(NCharacteristic& elem)
+    {
+        characteristic(elem);
+    }
+
+private:
+    void characteristic(const NCharacteristic& elem)
+    {
+        m_hash.integer(elem.kind);
+        m_hash.text(elem.name());
+        m_hash.text(elem.description);
+        m_hash.integer(elem.address);
+        m_hash.number(elem.min);
+        m_hash.number(elem.max);
+        m_hash.integer(elem.format.decimalPl);
+    }
+
+    void compuMethod(const NCompuMethod* compuMethod)
+    {
+        m_hash.integer(compuMethod != NULL);
+        if (compuMethod != NULL) {
+            m_hash.text(compuMethod->unit);
+            m_hash.integer(compuMethod->format.decimalPl);
+        }
+    }
+
+    void axis(const NAxis& axis)
+    {
+        m_hash.integer(axis.length);
+        m_hash.number(axis.min);
+        m_hash.number(axis.max);
+        m_hash.integer(axis.dataTypeRef != NULL ? axis.dataTypeRef->dataType : -1);
+        compuMethod(axis.compuMethodRef);
+
+        if (axis.getAxisStyle() == Extern) {
+            const NAxisPts* axisPts = static_cast<const NComAxis&>(axis).axisPtsRef;
+            m_hash.integer(axisPts != NULL);
+            if (axisPts != NULL) m_hash.integer(axisPts->address);
+        }
+    }
+
+    KeyHasher& m_hash;
+    const CrossReference& m_references;
+};
+
+} // namespace
+
+boost::uint64_t XdfGen::fragmentKey(NCharacteristic& characteristic) const
+{
+    KeyHasher hash;
+    hash.integer(TableFormat);
+    hash.integer(m_offset);
+
+    TableInputs inputs(hash, m_references);
+    dispatchCharacteristic(characteristic, inputs);
+    return hash.value();
+}
+
+void generateXdf(const NModule& module, const std::vector<std::string>& selected, std::ostream& out,
+                 unsigned threads, const CrossReference* references, FragmentCache* fragments)
+{
+    std::vector<NCharacteristic*> characteristics;
+    if (!selected.empty()) {
+        BOOST_FOREACH (const std::string& name, selected) {
+            NCharacteristic* characteristic = module.findCharacteristic(symbols().intern(name));
+            if (characteristic != NULL) {
+                characteristics.push_back(characteristic);
+            }
+            else {
+                std::cerr << "Unknown characteristic " << name << std::endl;
+            }
+        }
+    }
+    else {
+        module.loadAll(CharacteristicObject);
+
+        BOOST_FOREACH (CharacteristicHashMap::value_type i, module.characteristics) {
+            assert(i.second != NULL);
+            characteristics.push_back(i.second);
+        }
+    }
+
+    generateXdf(module, characteristics, out, threads, references, fragments);
+}
+
+namespace {
+
+// Renders tables of the document of a generator, or copies them from a
+// FragmentCache if they did not change. One per thread.
+class TableWriter
+{
+public:
+    TableWriter(const XdfGen& document, FragmentCache* fragments) :
+        m_stream(NULL),
+        m_generator(document, m_stream),
+        m_fragments(fragments)
+    { }
+
+    void write(NCharacteristic& characteristic, std::streambuf& out)
+    {
+        if (m_fragments == NULL) {
+            m_stream.rdbuf(&out);
+            dispatchCharacteristic(characteristic, m_generator);
+            return;
+        }
+
+        boost::uint64_t key = m_generator.fragmentKey(characteristic);
+        if (m_fragments->find(key, out)) return;
+
+        m_table.str(std::string());
+        m_stream.rdbuf(&m_table);
+        dispatchCharacteristic(characteristic, m_generator);
+
+        const std::string& table = m_table.str();
+        m_fragments->insert(key, table.data(), table.data() + table.size());
+        out.sputn(table.data(), table.size());
+    }
+
+private:
+    std::ostream m_stream; // writes to out, or to m_table to keep the text
+    XdfGen m_generator;
+    FragmentCache* m_fragments;
+    std::stringbuf m_table;
+};
+
+// Tables rendered by several threads, in chunks of consecutive
+// characteristics. The chunks are written in order as they are done, so
+// the output is the same for any number of threads, and only a few chunks
+// ahead of the writer are kept in memory.
+class ParallelTables
+{
+public:
+    static const std::size_t TablesPerChunk = 256;
+
+    ParallelTables(const XdfGen& generator, const std::vector<NCharacteristic*>& characteristics, unsigned threads,
+                   FragmentCache* fragments) :
+        m_generator(generator),
+        m_fragments(fragments),
+        m_characteristics(characteristics),
+        m_chunks((characteristics.size() + TablesPerChunk - 1) / TablesPerChunk),
+        m_window(2 * threads),
+        m_names(symbols()),
+        m_next(0),
+        m_written(0),
+        m_failed(false)
+    { }
+
+    void render()
+    {
+        SymbolScope scope(m_names);
+        TableWriter tables(m_generator, m_fragments);
+
+        for (;;) {
+            std::size_t i;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_changed.wait(lock, [this]() { return m_next < m_written + m_window || m_failed; });
+                if (m_next == m_chunks.size() || m_failed) return;
+                i = m_next++;
+            }
+
+            Chunk& chunk = m_chunks[i];
+            try {
+                std::size_t end = std::min(m_characteristics.size(), (i + 1) * TablesPerChunk);
+                for (std::size_t c = i * TablesPerChunk; c != end; ++c) {
+                    tables.write(*m_characteristics[c], chunk.xdf);
+                }
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_error = std::current_exception();
+                m_failed = true;
+                m_changed.notify_all();
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            chunk.done = true;
+            m_changed.notify_all();
+        }
+    }
+
+    // on the calling thread, while the workers render
+    void write(std::ostream& out)
+    {
+        for (std::size_t i = 0; i < m_chunks.size(); ++i) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_changed.wait(lock, [&]() { return m_chunks[i].done || m_failed; });
+                if (m_failed) return;
+            }
+
+            if (m_chunks[i].xdf.in_avail() > 0) out << &m_chunks[i].xdf;
+            out.flush(); // see OutputSink
+            std::stringbuf().swap(m_chunks[i].xdf); // releases the text
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_written;
+            m_changed.notify_all();
+        }
+    }
+
+    // the exception of a worker, if one failed
+    void rethrow() const
+    {
+        if (m_error) std::rethrow_exception(m_error);
+    }
+
+private:
+    struct Chunk
+    {
+        std::stringbuf xdf;
+        bool done;
+
+        Chunk() : done(false) { }
+    };
+
+    const XdfGen& m_generator;
+    FragmentCache* m_fragments;
+    const std::vector<NCharacteristic*>& m_characteristics;
+    std::vector<Chunk> m_chunks;
+    std::size_t m_window; // how many chunks may be ahead of the writer
+    SymbolTable& m_names; // of the thread which created it
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::size_t m_next;    // the next chunk to render
+    std::size_t m_written; // chunks written so far
+    bool m_failed;
+    std::exception_ptr m_error;
+};
+
+void renderTables(ParallelTables* tables)
+{
+    tables->render();
+}
+
+} // namespace
+
+void generateXdf(const NModule& module, const std::vector<NCharacteristic*>& characteristics, std::ostream& out,
+                 unsigned threads, const CrossReference* references, FragmentCache* fragments)
+{
+    // objects of a lazily parsed module are linked when they are needed
+    DanglingList dangling;
+    BOOST_FOREACH (NCharacteristic* characteristic, characteristics) {
+        if (!characteristic->linked) linkCharacteristic(module, *characteristic, dangling);
+    }
+    reportDangling(dangling);
+
+    std::unique_ptr<CrossReference> ownReferences;
+    if (references == NULL) {
+        ownReferences.reset(new CrossReference(module));
+        references = ownReferences.get();
+    }
+
+    XdfGen generator(module, *references, out, -0x800000);
+
+    threads = std::min<std::size_t>(threads, characteristics.size() / ParallelTables::TablesPerChunk);
+    if (threads < 2) {
+        TableWriter tables(generator, fragments);
+        BOOST_FOREACH (NCharacteristic* characteristic, characteristics) {
+            tables.write(*characteristic, *out.rdbuf());
+            out.flush(); // a table is complete, see OutputSink
+        }
+    }
+    else {
+        ParallelTables tables(generator, characteristics, threads, fragments);
+        std::vector<std::thread> workers;
+        for (unsigned i = 0; i < threads; ++i) {
+            workers.push_back(std::thread(renderTables, &tables));
+        }
+
+        tables.write(out);
+        BOOST_FOREACH (std::thread& worker, workers) {
+            worker.join();
+        }
+        tables.rethrow();
+    }
+
+    generator.epilogue();
 }
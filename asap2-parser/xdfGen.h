@@ -17,12 +17,17 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <sstream>
+#include <iostream>
 
 #include <boost/foreach.hpp>
 #include <boost/unordered_map.hpp>
+#include <boost/cstdint.hpp>
 
 #include "node.h"
+#include "crossReference.h"
+#include "fragmentCache.h"
 #include "XmlStream.hpp"
 
 using namespace xml;
@@ -30,14 +35,28 @@ using namespace xml;
 class XdfGen : public Visitor
 {
 public:
+    // the XDF is written to out as it is generated; the trace goes to
+    // std::clog, so it does not end up in the middle of the XDF
     XdfGen(
         const NModule& module,
+        const CrossReference& references,
+        std::ostream& out,
         int offset = 0);
 
+    // renders tables of the document of generator into out, as they would
+    // follow its header, e.g. on another thread
+    XdfGen(const XdfGen& generator, std::ostream& out);
+
     virtual ~XdfGen() { }
 
+    // closes the XDF
     void epilogue();
 
+    // A hash of everything the table of characteristic is rendered from: the
+    // characteristic, its record layout and compu method, the axes with
+    // their measurements and AXIS_PTS, and its categories. See FragmentCache.
+    boost::uint64_t fragmentKey(NCharacteristic& characteristic) const;
+
     // all top-level statements
     void visit(NBaseMap* elem);
     void visit(NCurve* elem);
@@ -55,28 +74,60 @@ public:
     void visit(NConstant* elem);
     void visit(NVariable* elem);
 
+    // for dispatchCharacteristic(), without virtual calls
+    void operator()(NMap<NComAxis>& elem);
+    void operator()(NMap<NStdAxis>& elem);
+    void operator()(NMap<NFixAxis>& elem);
+    void operator()(NCurve& elem)               { visit(&elem); }
+    void operator()(NValue& elem)               { visit(&elem); }
+    void operator()(NValBlk& elem)              { visit(&elem); }
+    void operator()(NCharacteristicText& elem)  { visit(&elem); }
+
 private:
     void createCategorys();
 
-    void createCategoryReferences(
-        const NIdentifier& id,
-        const NIdentifier& func_id,
-        const ExpressionList& refs);
-
-    void createCatRefsForMap(const NIdentifier& id);
+    void createCatRefsForMap(Symbol id);
 
     void createHeader();
 
-    void createMathEquation(
+    // the text of a MATH equation, formatted without allocating
+    struct MathEquation
+    {
+        char text[48]; // two floats of at most 13 characters
+        std::size_t length;
+    };
+
+    MathEquation mathEquation(
         short typeSize,
         bool typeSign,
         double max, double min);
 
+    // equal axes are shared (see DescriptorPool), so the equation of each
+    // is formatted once
+    const MathEquation& axisEquation(const NAxis& axis, short typeSize, bool typeSign);
+
+    void createMathEquation(const MathEquation& equation);
+
+    template<class Axis>
+    void generateMap(const NMap<Axis>& map);
+
+    // the axes of a map, returns the offset of the map data
+    unsigned int handleMapAxes(const NMap<NComAxis>& map, const NRecordLayout& recordLayout);
+    unsigned int handleMapAxes(const NMap<NStdAxis>& map, const NRecordLayout& recordLayout);
+    unsigned int handleMapAxes(const NMap<NFixAxis>& map, const NRecordLayout& recordLayout);
+
+    template<class Axis>
     unsigned int handleAxis(
-        const NAxis& axis,
+        const Axis& axis,
         unsigned int baseAddr,
         const char* name);
 
+    // the address of the axis data; offset becomes the space the axis takes
+    // in the map data
+    unsigned int locateAxis(const NComAxis& axis, unsigned int baseAddr, short typeSize, int& offset);
+    unsigned int locateAxis(const NStdAxis& axis, unsigned int baseAddr, short typeSize, int& offset);
+    unsigned int locateAxis(const NFixAxis& axis, unsigned int baseAddr, short typeSize, int& offset);
+
     void handleComMap(const NMap<NComAxis>* comMap);
 
     unsigned int handleStdMap(
@@ -85,14 +136,29 @@ private:
 
     void handleFixMap(const NMap<NFixAxis>* fixMap);
 
-    typedef boost::unordered_map<std::string, int> CategorysHashMap;
+    typedef boost::unordered_map<const NAxis*, MathEquation> EquationHashMap;
 
     // members:
-    CategorysHashMap m_categorys;
+    EquationHashMap m_axisEquations;
     bool m_done;
     const NModule& m_module;
+    const CrossReference& m_references; // has the category of each function
     int m_offset;
 
-    std::stringstream m_baseStream;
+    std::ostream& m_out;
     XmlStream<char> m_xdf;
 };
+
+// Converts the selected characteristics of module, or all of them if there
+// is no selection. Unknown names are reported on stderr. The tables are
+// rendered by up to threads threads; the output does not depend on their
+// number. references is built from module if it is not given. With
+// fragments, only the tables which are not in it are rendered, and added.
+void generateXdf(const NModule& module, const std::vector<std::string>& selected, std::ostream& out,
+                 unsigned threads = 1, const CrossReference* references = NULL,
+                 FragmentCache* fragments = NULL);
+
+// converts the given characteristics of module, in this order
+void generateXdf(const NModule& module, const std::vector<NCharacteristic*>& characteristics, std::ostream& out,
+                 unsigned threads = 1, const CrossReference* references = NULL,
+                 FragmentCache* fragments = NULL);
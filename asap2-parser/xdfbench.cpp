@@ -0,0 +1,94 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the cost of generating the XDF of one characteristic.
+ *
+ * usage: xdfbench file.a2l [runs]
+ *
+ * The file is parsed once; then the XDF of all characteristics is generated
+ * runs times into a discarding stream, also the debug output on stdout and
+ * std::clog.
+ * The result is printed on stderr, the parser still prints on stdout.
+ */
+
+#include <iostream>
+#include <streambuf>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+
+#include "node.h"
+#include "inputBuffer.h"
+#include "parse.h"
+#include "xdfGen.h"
+
+// drops everything written to it
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize n) { return n; }
+};
+
+int main(int argc, char* argv[])
+{
+    typedef std::chrono::steady_clock clock;
+
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " file.a2l [runs]" << std::endl;
+        return -1;
+    }
+
+    int runs = (argc > 2) ? atoi(argv[2]) : 5;
+    if (runs < 1) runs = 1;
+
+    InputBuffer input;
+    if (!input.mapFile(argv[1])) {
+        return -1;
+    }
+
+    NullBuffer discard;
+    std::streambuf* clogBuffer = std::clog.rdbuf(&discard); // the trace of the generator
+
+    Arena arena;
+    NProject* project = parseProject(input, arena, FastBackend);
+    if (project == NULL) {
+        std::clog.rdbuf(clogBuffer);
+        std::cerr << "Failed to parse " << argv[1] << std::endl;
+        return 1;
+    }
+
+    const NModule& module = project->m_module.ref();
+    std::vector<NCharacteristic*> characteristics;
+    BOOST_FOREACH (CharacteristicHashMap::value_type i, module.characteristics) {
+        characteristics.push_back(i.second);
+    }
+
+    std::ostream out(&discard);
+    double best = 0;
+    for (int run = 0; run < runs; ++run) {
+        clock::time_point start = clock::now();
+        generateXdf(module, characteristics, out);
+        double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        if (run == 0 || seconds < best) best = seconds;
+    }
+
+    std::clog.rdbuf(clogBuffer);
+    std::cerr << characteristics.size() << " characteristics in " << best << " s, "
+              << best * 1e9 / characteristics.size() << " ns per characteristic" << std::endl;
+    return 0;
+}
@@ -0,0 +1,162 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "xmlEscape.h"
+
+namespace xml
+{
+
+namespace {
+
+// U+0080 to U+009F in CP1252, the holes become U+FFFD
+const unsigned short Cp1252[32] = {
+    0x20AC, 0xFFFD, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0xFFFD, 0x017D, 0xFFFD,
+    0xFFFD, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0xFFFD, 0x017E, 0x0178
+};
+
+inline bool isSpecial(unsigned char c)
+{
+    return c < 0x20 || c >= 0x80 || c == '&' || c == '<' || c == '>' || c == '"';
+}
+
+inline bool isContinuation(const char* p, const char* end, unsigned char low = 0x80, unsigned char high = 0xBF)
+{
+    return p < end && static_cast<unsigned char>(*p) >= low && static_cast<unsigned char>(*p) <= high;
+}
+
+// the length of the valid UTF-8 sequence at p, 0 if there is none
+std::size_t utf8Length(const char* p, const char* end)
+{
+    unsigned char lead = *p;
+    const char* next = p + 1;
+
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        return isContinuation(next, end) ? 2 : 0;
+    }
+    if (lead >= 0xE0 && lead <= 0xEF) {
+        unsigned char low = (lead == 0xE0) ? 0xA0 : 0x80;  // not overlong
+        unsigned char high = (lead == 0xED) ? 0x9F : 0xBF; // no surrogate
+        return (isContinuation(next, end, low, high) && isContinuation(next + 1, end)) ? 3 : 0;
+    }
+    if (lead >= 0xF0 && lead <= 0xF4) {
+        unsigned char low = (lead == 0xF0) ? 0x90 : 0x80;
+        unsigned char high = (lead == 0xF4) ? 0x8F : 0xBF; // at most U+10FFFF
+        return (isContinuation(next, end, low, high) && isContinuation(next + 1, end)
+                && isContinuation(next + 2, end)) ? 4 : 0;
+    }
+    return 0;
+}
+
+void writeUtf8(std::streambuf& out, unsigned int codePoint)
+{
+    char buffer[3];
+    if (codePoint < 0x800) {
+        buffer[0] = char(0xC0 | (codePoint >> 6));
+        buffer[1] = char(0x80 | (codePoint & 0x3F));
+        out.sputn(buffer, 2);
+    }
+    else {
+        buffer[0] = char(0xE0 | (codePoint >> 12));
+        buffer[1] = char(0x80 | ((codePoint >> 6) & 0x3F));
+        buffer[2] = char(0x80 | (codePoint & 0x3F));
+        out.sputn(buffer, 3);
+    }
+}
+
+// writes the special character at p, returns how many bytes it took
+std::size_t writeSpecial(std::streambuf& out, const char* p, const char* end)
+{
+    unsigned char c = *p;
+    switch (c) {
+    case '&':   out.sputn("&amp;", 5); return 1;
+    case '<':   out.sputn("&lt;", 4); return 1;
+    case '>':   out.sputn("&gt;", 4); return 1;
+    case '"':   out.sputn("&quot;", 6); return 1;
+    case '\t':
+    case '\n':
+    case '\r':  out.sputc(c); return 1;
+    }
+
+    if (c < 0x20) {
+        out.sputc(' ');
+        return 1;
+    }
+
+    std::size_t length = utf8Length(p, end);
+    if (length != 0) {
+        out.sputn(p, length);
+        return length;
+    }
+
+    writeUtf8(out, (c < 0xA0) ? Cp1252[c - 0x80] : c);
+    return 1;
+}
+
+} // namespace
+
+const char* findSpecial(const char* begin, const char* end)
+{
+#if defined(__SSE2__)
+    // 16 bytes at a time; as signed bytes, everything from 0x80 on is
+    // below 0x20 as well
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i quot = _mm_set1_epi8('"');
+
+    for (; end - begin >= 16; begin += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmplt_epi8(bytes, space), _mm_cmpeq_epi8(bytes, amp)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, lt), _mm_cmpeq_epi8(bytes, gt)),
+                         _mm_cmpeq_epi8(bytes, quot)));
+
+        int mask = _mm_movemask_epi8(special);
+        if (mask != 0) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    for (; begin != end; ++begin) {
+        if (isSpecial(*begin)) return begin;
+    }
+    return end;
+}
+
+void writeEscaped(std::streambuf& out, const char* begin, const char* end)
+{
+    while (begin != end) {
+        const char* special = findSpecial(begin, end);
+        if (special != begin) {
+            out.sputn(begin, special - begin); // a run of plain ASCII
+        }
+        if (special == end) {
+            return;
+        }
+
+        begin = special + writeSpecial(out, special, end);
+    }
+}
+
+} // end namespace xml
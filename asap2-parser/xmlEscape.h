@@ -0,0 +1,36 @@
+/* Copyright (C) Josef Schmeißer 2011
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <streambuf>
+
+namespace xml
+{
+
+// Writes the text [begin, end) into the content or an attribute value of
+// an XML document: & < > and " are escaped, and the text is converted to
+// UTF-8. A2L files are usually CP1252 (a superset of Latin-1), so a byte
+// of 0x80 and above is taken as CP1252, unless it begins a valid UTF-8
+// sequence, which is copied as it is. Control characters which XML does
+// not allow become spaces.
+void writeEscaped(std::streambuf& out, const char* begin, const char* end);
+
+// the first byte in [begin, end) which writeEscaped() cannot copy as it is
+const char* findSpecial(const char* begin, const char* end);
+
+} // end namespace xml